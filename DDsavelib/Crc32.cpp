@@ -0,0 +1,228 @@
+// Crc32.cpp : Checksum of the compressed save data.
+//
+// Three kernels compute the same value: a carry-less multiply (PCLMULQDQ) folding kernel
+// for x86 CPUs that have it, and slice-by-16/slice-by-8 table kernels for everything else
+// and for the tails the folding kernel leaves over. The kernel is picked once, by CPUID.
+
+#include "Crc32.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CRC32_X86
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRC32_TARGET_PCLMUL
+#else
+#include <cpuid.h>
+#define CRC32_TARGET_PCLMUL __attribute__((target("pclmul,sse2")))
+#endif
+#endif
+
+namespace
+{
+	const unsigned int Polynomial = 0xEDB88320;
+
+	// Table[0] is the classic byte-at-a-time table; Table[k] advances a byte through k more zero bytes
+	struct Crc32Tables
+	{
+		unsigned int Table[16][256];
+
+		constexpr Crc32Tables() : Table()
+		{
+			for (unsigned int c = 0; c < 256; ++c)
+			{
+				unsigned int x = c;
+				for (int b = 0; b < 8; ++b)
+				{
+					x = (x & 1) ? ((x >> 1) ^ Polynomial) : (x >> 1);
+				}
+				Table[0][c] = x;
+			}
+			for (unsigned int c = 0; c < 256; ++c)
+			{
+				for (int k = 1; k < 16; ++k)
+				{
+					unsigned int prev = Table[k - 1][c];
+					Table[k][c] = (prev >> 8) ^ Table[0][prev & 255];
+				}
+			}
+		}
+	};
+
+	constexpr Crc32Tables Tables;
+	static_assert(Tables.Table[0][1] == 0x77073096, "CRC table generated incorrectly");
+
+	inline unsigned int Load32(const unsigned char *p)
+	{
+		// the slicing kernels assume a little-endian host, like every platform DDsavelib targets
+		unsigned int value;
+		memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	unsigned int CrcBytes(const unsigned char *p, size_t size, unsigned int crc)
+	{
+		while (size--)
+		{
+			crc = (crc >> 8) ^ Tables.Table[0][(crc ^ *p++) & 255];
+		}
+		return crc;
+	}
+
+	unsigned int CrcSlice8(const unsigned char *p, size_t size, unsigned int crc)
+	{
+		const unsigned int (*t)[256] = Tables.Table;
+		while (size >= 8)
+		{
+			unsigned int a = Load32(p) ^ crc;
+			unsigned int b = Load32(p + 4);
+			crc = t[7][a & 255] ^ t[6][(a >> 8) & 255] ^ t[5][(a >> 16) & 255] ^ t[4][a >> 24] ^
+				t[3][b & 255] ^ t[2][(b >> 8) & 255] ^ t[1][(b >> 16) & 255] ^ t[0][b >> 24];
+			p += 8;
+			size -= 8;
+		}
+		return CrcBytes(p, size, crc);
+	}
+
+	unsigned int CrcSlice16(const unsigned char *p, size_t size, unsigned int crc)
+	{
+		const unsigned int (*t)[256] = Tables.Table;
+		while (size >= 16)
+		{
+			unsigned int a = Load32(p) ^ crc;
+			unsigned int b = Load32(p + 4);
+			unsigned int c = Load32(p + 8);
+			unsigned int d = Load32(p + 12);
+			crc = t[15][a & 255] ^ t[14][(a >> 8) & 255] ^ t[13][(a >> 16) & 255] ^ t[12][a >> 24] ^
+				t[11][b & 255] ^ t[10][(b >> 8) & 255] ^ t[9][(b >> 16) & 255] ^ t[8][b >> 24] ^
+				t[7][c & 255] ^ t[6][(c >> 8) & 255] ^ t[5][(c >> 16) & 255] ^ t[4][c >> 24] ^
+				t[3][d & 255] ^ t[2][(d >> 8) & 255] ^ t[1][(d >> 16) & 255] ^ t[0][d >> 24];
+			p += 16;
+			size -= 16;
+		}
+		return CrcSlice8(p, size, crc);
+	}
+
+#ifdef CRC32_X86
+	// Folds 64 bytes per iteration with carry-less multiplies, then Barrett-reduces to 32 bits.
+	// Constants are for the reflected polynomial, from Intel's "Fast CRC Computation for Generic
+	// Polynomials Using PCLMULQDQ Instruction". size must be a multiple of 16 and at least 64.
+	CRC32_TARGET_PCLMUL unsigned int CrcFold(const unsigned char *p, size_t size, unsigned int crc)
+	{
+		const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+		const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+		const __m128i k5k0 = _mm_set_epi64x(0x0000000000, 0x0163cd6124);
+		const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+		const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+		__m128i x1 = _mm_loadu_si128((const __m128i *)(p + 0x00));
+		__m128i x2 = _mm_loadu_si128((const __m128i *)(p + 0x10));
+		__m128i x3 = _mm_loadu_si128((const __m128i *)(p + 0x20));
+		__m128i x4 = _mm_loadu_si128((const __m128i *)(p + 0x30));
+		x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+		p += 64;
+		size -= 64;
+
+		//Fold four lanes in parallel
+		while (size >= 64)
+		{
+			__m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+			__m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+			__m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+			__m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+			x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+			x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+			x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i *)(p + 0x00)));
+			x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i *)(p + 0x10)));
+			x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i *)(p + 0x20)));
+			x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i *)(p + 0x30)));
+			p += 64;
+			size -= 64;
+		}
+
+		//Fold the four lanes into one
+		__m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+		x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+		//Fold any remaining 16-byte blocks
+		while (size >= 16)
+		{
+			x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+			x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+			x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)p)), x5);
+			p += 16;
+			size -= 16;
+		}
+
+		//Fold 128 bits down to 64
+		x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+		x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+		x2 = _mm_srli_si128(x1, 4);
+		x1 = _mm_and_si128(x1, mask32);
+		x1 = _mm_clmulepi64_si128(x1, k5k0, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		//Barrett reduction to 32 bits
+		x2 = _mm_and_si128(x1, mask32);
+		x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+		x2 = _mm_and_si128(x2, mask32);
+		x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+		x1 = _mm_xor_si128(x1, x2);
+
+		return (unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+	}
+
+	bool HasPclmul()
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[2] & (1 << 1)) != 0;
+#else
+		unsigned int eax, ebx, ecx, edx;
+		return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) != 0;
+#endif
+	}
+
+	unsigned int CrcPclmul(const unsigned char *p, size_t size, unsigned int crc)
+	{
+		if (size >= 64)
+		{
+			size_t folded = size & ~(size_t)15;
+			crc = CrcFold(p, folded, crc);
+			p += folded;
+			size -= folded;
+		}
+		return CrcSlice16(p, size, crc);
+	}
+#endif
+
+	typedef unsigned int (*CrcKernel)(const unsigned char *p, size_t size, unsigned int crc);
+
+	CrcKernel SelectKernel()
+	{
+#ifdef CRC32_X86
+		if (HasPclmul())
+			return CrcPclmul;
+#endif
+		return CrcSlice16;
+	}
+}
+
+unsigned int crc32jam(const unsigned char *block, size_t size, unsigned int crc)
+{
+	static const CrcKernel kernel = SelectKernel();
+	return kernel(block, size, crc);
+}
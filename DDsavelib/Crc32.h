@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stddef.h>
+
+// CRC-32 (reflected polynomial 0xEDB88320) without the final inversion, which is what header_s::hash holds.
+// Pass the previous result as crc to continue a checksum across several blocks.
+unsigned int crc32jam(const unsigned char *block, size_t size, unsigned int crc = 0xFFFFFFFF);
@@ -3,227 +3,1431 @@
 
 #include "DDsavelib.h"
 
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
 #include <stdio.h>
-#include <tchar.h>
 #include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <vector>
 
 #include "easyzlib.h"
+#include "Crc32.h"
+#include "SavFormat.h"
+#include "SavFile.h"
+#include "SavXml.h"
+#include "SavPatch.h"
+#include "SavIndex.h"
+#include "SavBinary.h"
+#include "SavThreadPool.h"
+#include "SavDeflate.h"
+#include "SavContext.h"
+#include "SavPackedCache.h"
+#include "SavAccess.h"
+#include "SavCheckpoint.h"
+#include "SavPawn.h"
+#include <string>
 
 /*
 Notes:
 - Conversion only works one way: console to pc. And conversion only works with Dark Arisen savegames.
+- No exception crosses into the caller: every export catches them and returns ERR_MEMORY, as running out of
+  memory is all that throws below them.
 */
 
-//Size of full file is always 524288 (extra data are nulls)
-#define SAVESIZE 524288
 #define MAXPATH 260
+//Output window handed to UnpackStream callbacks when the caller doesn't pick one
+#define DEFAULT_WINDOWSIZE (64 * 1024)
+//Smallest zlib stream: 2 byte header, an empty final block and a 4 byte trailer
+#define ZLIB_MINSIZE 8
+//Compressed bytes are written to the file in blocks of this size
+#define REPACK_BLOCKSIZE (64 * 1024)
+
+//Deflate settings behind each SAVPROFILE_ value
+struct RepackProfile
+{
+	int level;
+	int strategy;
+};
+
+const RepackProfile RepackProfiles[] = {
+	{ 1, EZ_DEFAULT_STRATEGY }, //SAVPROFILE_FASTEST
+	{ EZ_DEFAULT_COMPRESSION, EZ_DEFAULT_STRATEGY }, //SAVPROFILE_BALANCED
+	{ 9, EZ_DEFAULT_STRATEGY } //SAVPROFILE_SMALLEST
+};
 
 int ERR_READ = 1;
 int ERR_WRITE = 2;
 int ERR_FORMAT = 3;
 int ERR_UNPACK = 4;
+int ERR_BUFFERSIZE = 5;
+int ERR_ABORTED = 6;
+int ERR_CHECKSUM = 7;
+int ERR_PATH = 8;
+int ERR_TOOLARGE = 9;
+int ERR_ARGUMENT = SAVERR_ARGUMENT;
 int ERR_STREAM = EZ_STREAM_ERROR;
 int ERR_DATA = EZ_DATA_ERROR;
 int ERR_MEMORY = EZ_MEM_ERROR;
 int ERR_BUFFER = EZ_BUF_ERROR;
+int ERR_NOTCACHED = -100;
 
-#pragma pack(push, 1)
-struct header_s
-{
-	unsigned int u1; //Version (21 for DDDA console and DDDA PC, and 5 for original DD on console)
-	unsigned int realSize; //Real size of compressed save game data
-	unsigned int compressedSize;
-	unsigned int u2; //Always 860693325
-	unsigned int u3; //Always 0
-	unsigned int u4; //Always 860700740
-	unsigned int hash; //Checksum of compressed save data
-	unsigned int u5; //Always 1079398965
-};
-#pragma pack(pop)
+// Reads only the header at the start of a packed save
+int ReadHeader(const char *path, header_s *outHeader)
+{
+	SavFile file;
+	if (file.OpenRead(path) != 0)
+	{
+		printf("Error: Could not open file %s for reading.\n", path);
+		return ERR_READ;
+	}
 
-unsigned int Crc32Table[256];
+	unsigned int headerSize = 0;
+	int errcode = file.ReadAt(0, outHeader, sizeof(header_s), &headerSize);
+	if (errcode)
+		return errcode;
 
-unsigned int crc32jam(unsigned char *Block, unsigned int uSize)
+	if (headerSize != sizeof(header_s) || outHeader->u1 != 21)
+	{
+		return ERR_FORMAT;
+	}
+	return 0;
+}
+
+// Inflates a whole payload, noting its access points in access, if given, unless they are there already
+int UnpackSave(	SavStreamCache &streams,
+				SavAccessCache *access,
+				const header_s *packedHeader,
+				const unsigned char *compressedData,
+				unsigned char *outUnpackedText,
+				unsigned int *outUnpackedSize)
 {
-	unsigned int x = -1; //initial value
-	unsigned int c = 0;
+	ezstream *stream = streams.AcquireInflate();
+	if (!stream)
+		return ERR_MEMORY;
 
-	while (c < uSize)
+	//The whole payload and all of realSize in one go
+	long inLen = (long)packedHeader->compressedSize;
+	long unpackedSize = (long)packedHeader->realSize;
+	int zcode = access && !access->Has(packedHeader) ?
+		InflateAccessible(*access, stream, packedHeader, outUnpackedText, &unpackedSize, compressedData, &inLen) :
+		ezinflatestream(stream, outUnpackedText, &unpackedSize, compressedData, &inLen);
+	streams.ReleaseInflate(stream);
+	*outUnpackedSize = (unsigned int)unpackedSize;
+
+	if (zcode == EZ_STREAM_END)
+		return 0;
+	if (zcode < 0 && zcode != EZ_BUF_ERROR)
+		return zcode;
+	//Stopped short: out of room means there is more than realSize, out of input a truncated payload
+	return unpackedSize == (long)packedHeader->realSize ? ERR_BUFFER : ERR_DATA;
+}
+
+// Checks the header against the file size and the checksum against the compressed data
+int CheckPackedSave(const unsigned char *packedData, unsigned int packedDataSize)
+{
+	const header_s *packedHeader = (const header_s *)packedData;
+	if (packedDataSize < sizeof(header_s) ||
+		packedHeader->u1 != 21 ||
+		packedHeader->compressedSize > packedDataSize - sizeof(header_s))
 	{
-		x = ((x >> 8) ^ Crc32Table[((x ^ Block[c]) & 255)]);
-		c++;
+		return ERR_FORMAT;
+	}
+	if (crc32jam(&packedData[sizeof(header_s)], packedHeader->compressedSize) != packedHeader->hash)
+	{
+		return ERR_CHECKSUM;
 	}
-	return x;
+	return 0;
+}
+
+// Maps a whole packed save and checks it. Inflate then reads the compressed bytes straight
+// from the mapping, so the file is never copied into a buffer of its own.
+int MapPackedSave(const char *pathPackedSav, SavMappedFile &outPackedFile)
+{
+	int errcode = outPackedFile.Open(pathPackedSav);
+	if (errcode == ERR_READ)
+		printf("Error: Could not open file %s for reading.\n", pathPackedSav);
+	if (errcode)
+		return errcode;
+
+	errcode = CheckPackedSave(outPackedFile.GetData(), outPackedFile.GetSize());
+	if (errcode)
+		outPackedFile.Close();
+	return errcode;
+}
+
+// Unpacks a mapped and checked save into a buffer of bufferSize bytes, failing if its realSize doesn't fit.
+// If packed or access are given, the save's payload or access points are remembered there.
+int UnpackMapped(	SavStreamCache &streams,
+					SavPackedCache *packed,
+					SavAccessCache *access,
+					const unsigned char *packedData,
+					char *outUnpackedText,
+					unsigned int bufferSize)
+{
+	//Header
+	const header_s *packedHeader = (const header_s *)packedData;
+	if (packedHeader->realSize > bufferSize)
+		return ERR_BUFFERSIZE;
+
+	//Uncompress data
+	unsigned int unpackedTextSize = 0;
+	int errcode = UnpackSave(	streams,
+								access,
+								packedHeader,
+								&packedData[sizeof(header_s)],
+								reinterpret_cast<unsigned char *>(outUnpackedText),
+								&unpackedTextSize);
+
+	//So repacking the text unchanged can write these bytes straight back
+	if (packed && !errcode && unpackedTextSize == packedHeader->realSize)
+		packed->Remember(packedHeader, &packedData[sizeof(header_s)]);
+	return errcode;
+}
+
+// Unpacks into a buffer of bufferSize bytes, failing if the save's realSize doesn't fit.
+// outHeader, if given, gets a copy of the save's header. packed and access are as for UnpackMapped.
+int UnpackFile(	SavStreamCache &streams,
+				SavPackedCache *packed,
+				SavAccessCache *access,
+				const char *pathPackedSav,
+				char *outUnpackedText,
+				unsigned int bufferSize,
+				header_s *outHeader = 0)
+{
+	SavMappedFile packedFile;
+	int errcode = MapPackedSave(pathPackedSav, packedFile);
+	if (errcode)
+		return errcode;
+
+	if (outHeader)
+		*outHeader = *(const header_s *)packedFile.GetData();
+	return UnpackMapped(streams, packed, access, packedFile.GetData(), outUnpackedText, bufferSize);
+}
+
+// Inflates only the text under spans into outUnpackedText, at the same offsets as in the whole text, from
+// the save's access points. Spans closer together than the access points are inflated in one run.
+// Returns ERR_NOTCACHED if the save's access points aren't in access.
+int UnpackSpans(	SavStreamCache &streams,
+					SavAccessCache &access,
+					const header_s *packedHeader,
+					const unsigned char *compressedData,
+					const SavValueSpan *spans,
+					unsigned int spanCount,
+					char *outUnpackedText)
+{
+	if (!access.Has(packedHeader))
+		return ERR_NOTCACHED;
+
+	std::vector<SavValueSpan> found;
+	for (unsigned int i = 0; i < spanCount; ++i)
+	{
+		if (spans[i].offset == SAVPATH_NOTFOUND)
+			continue;
+		if (spans[i].offset > packedHeader->realSize || spans[i].size > packedHeader->realSize - spans[i].offset)
+			return ERR_FORMAT;
+		found.push_back(spans[i]);
+	}
+	std::sort(found.begin(), found.end(), [](const SavValueSpan &a, const SavValueSpan &b) { return a.offset < b.offset; });
+
+	SavArena *arena = streams.AcquireArena();
+	if (!arena)
+		return ERR_MEMORY;
+
+	int errcode = 0;
+	size_t i = 0;
+	while (!errcode && i < found.size())
+	{
+		unsigned int begin = found[i].offset;
+		unsigned int end = begin + found[i].size;
+		for (++i; i < found.size() && (found[i].offset <= end || found[i].offset - end <= SAVACCESS_SPAN); ++i)
+			end = std::max(end, found[i].offset + found[i].size);
+		errcode = access.InflateRange(	streams,
+										*arena,
+										packedHeader,
+										compressedData,
+										begin,
+										end - begin,
+										reinterpret_cast<unsigned char *>(outUnpackedText) + begin);
+	}
+
+	streams.ReleaseArena(arena);
+	return errcode;
 }
 
-void crc32tab()
+// Inflates the save's payload a window at a time, handing each filled window to callback
+int InflateWindows(	SavStreamCache &streams,
+					const header_s *packedHeader,
+					const unsigned char *compressedData,
+					unsigned int windowSize,
+					UnpackCallback callback,
+					void *userData)
 {
-	unsigned int x, c, b;
-	c = 0;
+	ezstream *stream = streams.AcquireInflate();
+	SavArena *arena = streams.AcquireArena();
+	unsigned char *window = arena ? (unsigned char *)arena->Allocate(windowSize) : 0;
+	if (!stream || !window)
+	{
+		streams.ReleaseInflate(stream);
+		streams.ReleaseArena(arena);
+		return ERR_MEMORY;
+	}
 
-	while (c <= 255)
+	unsigned int inputLeft = packedHeader->compressedSize;
+	unsigned int totalOut = 0;
+	int errcode = 0;
+
+	while (true)
 	{
-		x = c;
-		b = 0;
-		while (b <= 7)
+		long inLen = (long)inputLeft;
+		long outLen = (long)windowSize;
+		int zcode = ezinflatestream(stream, window, &outLen, compressedData, &inLen);
+		compressedData += inLen;
+		inputLeft -= (unsigned int)inLen;
+		totalOut += (unsigned int)outLen;
+
+		if (zcode < 0)
 		{
-			if ((x & 1) != 0)
-				x = ((x >> 1) ^ 0xEDB88320); //polynomial
-			else
-				x = (x >> 1);
-			b++;
+			//All remaining input and a whole window were offered, so a buffer error means the payload is truncated
+			errcode = zcode == EZ_BUF_ERROR ? ERR_DATA : zcode;
+			break;
+		}
+		if (outLen > 0 && callback((const char *)window, (unsigned int)outLen, userData) != 0)
+		{
+			errcode = ERR_ABORTED;
+			break;
+		}
+		if (zcode == EZ_STREAM_END)
+		{
+			if (totalOut != packedHeader->realSize)
+				errcode = ERR_UNPACK;
+			break;
 		}
-		Crc32Table[c] = x;
-		c++;
 	}
+
+	streams.ReleaseArena(arena);
+	streams.ReleaseInflate(stream);
+	return errcode;
 }
 
-// if maxRead == 0, reads to end of file
-int ReadFile(	const char *path,
-				unsigned char **outFileData,
-				unsigned int *outDataSize,
-				unsigned int maxRead = 0)
+// Unpacks a window at a time like UnpackStream. outHeader, if given, gets a copy of the save's header.
+int StreamFile(	SavStreamCache &streams,
+				const char *pathPackedSav,
+				unsigned int windowSize,
+				UnpackCallback callback,
+				void *userData,
+				header_s *outHeader = 0)
 {
-	FILE *file;
-	fopen_s(&file, path, "rb");
-	if (!file)
+	if (windowSize == 0)
+		windowSize = DEFAULT_WINDOWSIZE;
+
+	SavMappedFile packedFile;
+	int errcode = MapPackedSave(pathPackedSav, packedFile);
+	if (errcode)
+		return errcode;
+
+	const unsigned char *packedData = packedFile.GetData();
+	if (outHeader)
+		*outHeader = *(const header_s *)packedData;
+	return InflateWindows(	streams,
+							(const header_s *)packedData,
+							&packedData[sizeof(header_s)],
+							windowSize,
+							callback,
+							userData);
+}
+
+DDSAVELIB_API int Unpack(const char *pathPackedSav, char *outUnpackedText)
+{
+	try
 	{
-		printf("Error: Could not open file %s for reading.\n", path);
-		return ERR_READ;
+		SavStreamCache streams;
+		return UnpackFile(streams, 0, 0, pathPackedSav, outUnpackedText, 0xFFFFFFFF);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
 	}
+}
 
-	//Get size of file
-	fpos_t fpos;
-	fseek(file, 0, SEEK_END);
-	fgetpos(file, &fpos);
-	fseek(file, 0, SEEK_SET);
-	*outDataSize = (unsigned int)fpos;
+DDSAVELIB_API int GetUnpackedSize(const char *pathPackedSav, unsigned int *outSize)
+{
+	try
+	{
+		header_s header;
+		int errcode = ReadHeader(pathPackedSav, &header);
+		if (errcode)
+			return errcode;
 
-	if (maxRead > 0 && maxRead < *outDataSize)
+		*outSize = header.realSize;
+		return 0;
+	}
+	catch (...)
 	{
-		*outDataSize = maxRead;
+		return ERR_MEMORY;
 	}
+}
 
-	//Create buffer for new file
-	*outFileData = new unsigned char[*outDataSize];
+DDSAVELIB_API int UnpackToBuffer(const char *pathPackedSav, char *outUnpackedText, unsigned int bufferSize)
+{
+	try
+	{
+		SavStreamCache streams;
+		return UnpackFile(streams, 0, 0, pathPackedSav, outUnpackedText, bufferSize);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+// UnpackIndexed on a save already mapped from pathPackedSav, into a buffer of its realSize. With access, the
+// save's access points are noted there, and if the spans are indexed and its points are there already, only the
+// text under the spans is inflated, as SavContextUnpackSpans allows.
+int UnpackIndexedMapped(	SavStreamCache &streams,
+							SavAccessCache *access,
+							const char *pathPackedSav,
+							const unsigned char *packedData,
+							const char *const *paths,
+							unsigned int pathCount,
+							char *outUnpackedText,
+							SavValueSpan *outSpans)
+{
+	const header_s *packedHeader = (const header_s *)packedData;
+	unsigned int bufferSize = packedHeader->realSize;
+	int errcode = 0;
+
+	//With the spans indexed, a save whose access points are known only needs the text around them
+	std::string indexPath = std::string(pathPackedSav) + SAVINDEX_EXTENSION;
+	if (LoadSavIndex(indexPath.c_str(), packedHeader->hash, packedHeader->realSize, paths, pathCount, outSpans) == 0)
+	{
+		if (access)
+		{
+			errcode = UnpackSpans(streams, *access, packedHeader, &packedData[sizeof(header_s)], outSpans, pathCount, outUnpackedText);
+			if (errcode != ERR_NOTCACHED)
+				return errcode;
+		}
+		return UnpackMapped(streams, 0, access, packedData, outUnpackedText, bufferSize);
+	}
 
-	//Read in file
-	fread(*outFileData, 1, *outDataSize, file);
-	fclose(file);
+	errcode = UnpackMapped(streams, 0, access, packedData, outUnpackedText, bufferSize);
+	if (errcode)
+		return errcode;
+
+	SavPathMatcher matcher(paths, pathCount);
+	errcode = matcher.Resolve(outUnpackedText, packedHeader->realSize, outSpans);
+	if (errcode)
+		return errcode;
+
+	//The index is only a cache, so failing to write it (say, to a read-only folder) isn't an error
+	SaveSavIndex(indexPath.c_str(), packedHeader->hash, packedHeader->realSize, paths, pathCount, outSpans);
 	return 0;
 }
 
-int UnpackSave(	header_s *packedHeader,
-				unsigned char *packedData,
-				unsigned char **outUnpackedText,
-				unsigned int *outUnpackedSize)
+DDSAVELIB_API int UnpackIndexed(const char *pathPackedSav, const char *const *paths, unsigned int pathCount, char *outUnpackedText, unsigned int bufferSize, SavValueSpan *outSpans)
 {
-	*outUnpackedSize = packedHeader->realSize;
-	int errcode = ezuncompress(	*outUnpackedText,
-								(long *)outUnpackedSize,
-								&packedData[sizeof(header_s)],
-								(long)packedHeader->compressedSize);
-	delete[]packedData;
-	if (errcode)
+	try
 	{
-		return errcode;
+		SavStreamCache streams;
+		SavMappedFile packedFile;
+		int errcode = MapPackedSave(pathPackedSav, packedFile);
+		if (errcode)
+			return errcode;
+
+		const header_s *packedHeader = (const header_s *)packedFile.GetData();
+		if (packedHeader->realSize > bufferSize)
+			return ERR_BUFFERSIZE;
+		return UnpackIndexedMapped(streams, 0, pathPackedSav, packedFile.GetData(), paths, pathCount, outUnpackedText, outSpans);
 	}
-	return 0;
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavPawnConfigOpen(SavPawnConfig **outConfig)
+{
+	try
+	{
+		*outConfig = new (std::nothrow) SavPawnConfig();
+		return *outConfig ? 0 : ERR_MEMORY;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavPawnConfigAdd(SavPawnConfig *config, unsigned int slot, const char *path, int flags)
+{
+	try
+	{
+		if (slot >= SAVPAWN_SLOTCOUNT)
+			return ERR_ARGUMENT;
+		config->Add(slot, path, flags);
+		return 0;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API void SavPawnConfigClose(SavPawnConfig *config)
+{
+	delete config;
 }
 
-__declspec(dllexport) int Unpack(const char *pathPackedSav, char *outUnpackedText)
+// ExtractPawn with the context's streams; with access, only the text around the values may be inflated
+int ExtractPawnWith(	SavStreamCache &streams,
+						SavAccessCache *access,
+						const char *pathPackedSav,
+						const SavPawnConfig *config,
+						unsigned int slot,
+						SavPawnValue *outValues,
+						unsigned int capacity,
+						unsigned int *outCount)
 {
-	unsigned char *packedData = 0;
-	unsigned int packedDataSize = 0;
-	int errcode = ReadFile(pathPackedSav, &packedData, &packedDataSize);
+	*outCount = 0;
+	if (slot >= SAVPAWN_SLOTCOUNT)
+		return ERR_ARGUMENT;
+
+	SavMappedFile packedFile;
+	int errcode = MapPackedSave(pathPackedSav, packedFile);
 	if (errcode)
 		return errcode;
 
-	//Header
-	header_s *packedHeader = (header_s *)packedData;
-	if (packedHeader->u1 != 21)
+	std::vector<const char *> paths;
+	config->GetPaths(slot, &paths);
+	std::vector<SavValueSpan> spans(paths.size());
+
+	//Left uninitialized, so when only the text around the values is inflated the rest is never touched
+	const header_s *packedHeader = (const header_s *)packedFile.GetData();
+	std::unique_ptr<char[]> text(new (std::nothrow) char[packedHeader->realSize > 0 ? packedHeader->realSize : 1]);
+	if (!text)
+		return ERR_MEMORY;
+
+	errcode = UnpackIndexedMapped(streams, access, pathPackedSav, packedFile.GetData(), paths.data(), (unsigned int)paths.size(), text.get(), spans.data());
+	if (errcode)
+		return errcode;
+	return config->Read(slot, text.get(), spans.data(), outValues, capacity, outCount);
+}
+
+DDSAVELIB_API int ExtractPawn(const char *pathPackedSav, const SavPawnConfig *config, unsigned int slot, SavPawnValue *outValues, unsigned int capacity, unsigned int *outCount)
+{
+	try
 	{
-		return ERR_FORMAT;
+		SavStreamCache streams;
+		return ExtractPawnWith(streams, 0, pathPackedSav, config, slot, outValues, capacity, outCount);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
 	}
+}
 
-	//Uncompress data
-	unsigned int unpackedTextSize = 0;
-	errcode = UnpackSave(	packedHeader,
-							packedData,
-							reinterpret_cast<unsigned char **>(&outUnpackedText),
-							&unpackedTextSize);
+// UnpackRange on streams, whose arenas keep the whole text's buffer for the next time. With access, the range is
+// inflated from the save's access points there if it has any, and the whole text noting them otherwise.
+int UnpackRangeFile(SavStreamCache &streams, SavAccessCache *access, const char *pathPackedSav, unsigned int offset, unsigned int size, char *outText)
+{
+	SavMappedFile packedFile;
+	int errcode = MapPackedSave(pathPackedSav, packedFile);
 	if (errcode)
 		return errcode;
 
+	const unsigned char *packedData = packedFile.GetData();
+	const header_s *packedHeader = (const header_s *)packedData;
+	if (offset > packedHeader->realSize || size > packedHeader->realSize - offset)
+		return ERR_BUFFERSIZE;
+
+	SavArena *arena = streams.AcquireArena();
+	if (!arena)
+		return ERR_MEMORY;
+
+	errcode = !access ? ERR_NOTCACHED : access->InflateRange(	streams,
+																*arena,
+																packedHeader,
+																&packedData[sizeof(header_s)],
+																offset,
+																size,
+																reinterpret_cast<unsigned char *>(outText));
+	if (errcode == ERR_NOTCACHED)
+	{
+		//No access points: the whole text it is, which notes them in access for next time
+		char *text = (char *)arena->Allocate(packedHeader->realSize);
+		errcode = text ? UnpackMapped(streams, 0, access, packedData, text, packedHeader->realSize) : ERR_MEMORY;
+		if (!errcode)
+			memcpy(outText, text + offset, size);
+	}
+
+	streams.ReleaseArena(arena);
+	return errcode;
+}
+
+DDSAVELIB_API int UnpackRange(const char *pathPackedSav, unsigned int offset, unsigned int size, char *outText)
+{
+	try
+	{
+		SavStreamCache streams;
+		return UnpackRangeFile(streams, 0, pathPackedSav, offset, size, outText);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+// Text UnpackDocument hands out, which belongs to DDsavelib until SavDocumentClose
+struct SavDocument
+{
+	SavDocument() : text(0), size(0) {}
+	~SavDocument() { delete[] text; }
+
+	char *text;
+	unsigned int size;
+	mutable SavSaveCache saves; //The save the text came from, with the text itself as the checkpoint
+};
+
+DDSAVELIB_API int UnpackDocument(const char *pathPackedSav, SavDocument **outDocument)
+{
+	try
+	{
+		*outDocument = 0;
+		SavMappedFile packedFile;
+		int errcode = MapPackedSave(pathPackedSav, packedFile);
+		if (errcode)
+			return errcode;
+
+		const header_s *packedHeader = (const header_s *)packedFile.GetData();
+		SavDocument *document = new (std::nothrow) SavDocument();
+		//Left uninitialized, since inflating writes every byte
+		if (document)
+			document->text = new (std::nothrow) char[packedHeader->realSize > 0 ? packedHeader->realSize : 1];
+		if (!document || !document->text)
+		{
+			delete document;
+			return ERR_MEMORY;
+		}
+		document->size = packedHeader->realSize;
+
+		SavStreamCache streams;
+		errcode = UnpackMapped(streams, &document->saves.packed, &document->saves.access, packedFile.GetData(), document->text, document->size);
+		if (errcode)
+		{
+			delete document;
+			return errcode;
+		}
+		//A document is unpacked to be edited and repacked, which then only recompresses from the first edit
+		document->saves.checkpoint.Borrow((const header_s *)packedFile.GetData(), reinterpret_cast<const unsigned char *>(document->text));
+		*outDocument = document;
+		return 0;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavDocumentGetText(const SavDocument *document, const char **outText, unsigned int *outSize)
+{
+	try
+	{
+		*outText = document->text;
+		*outSize = document->size;
+		return 0;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API void SavDocumentClose(SavDocument *document)
+{
+	delete document;
+}
+
+DDSAVELIB_API int UnpackStream(const char *pathPackedSav, unsigned int windowSize, UnpackCallback callback, void *userData)
+{
+	try
+	{
+		SavStreamCache streams;
+		return StreamFile(streams, pathPackedSav, windowSize, callback, userData);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+// A context with threadCount threads, or null if there is no memory for it or a thread can't be started
+SavContext *NewContext(unsigned int threadCount)
+{
+	try
+	{
+		return new (std::nothrow) SavContext(threadCount);
+	}
+	catch (const std::system_error &)
+	{
+		return 0;
+	}
+	catch (const std::bad_alloc &)
+	{
+		return 0;
+	}
+}
+
+DDSAVELIB_API int UnpackBatch(SavBatchItem *items, unsigned int itemCount, unsigned int threadCount, unsigned int windowSize)
+{
+	try
+	{
+		if (itemCount == 0)
+			return 0;
+
+		//Threads beyond one per save would only sit idle
+		if (threadCount == 0)
+			threadCount = std::thread::hardware_concurrency();
+		if (threadCount == 0 || threadCount > itemCount)
+			threadCount = itemCount;
+
+		//Each thread reuses the inflate streams of the saves before it
+		std::unique_ptr<SavContext> context(NewContext(threadCount));
+		if (!context)
+			return ERR_MEMORY;
+		SavContext *shared = context.get();
+		context->pool.For(itemCount, [items, windowSize, shared](unsigned int i)
+		{
+			SavBatchItem &item = items[i];
+			header_s header;
+			header.realSize = 0;
+			if (item.callback)
+				item.errcode = StreamFile(shared->streams, item.pathPackedSav, windowSize, item.callback, item.userData, &header);
+			else
+				item.errcode = UnpackFile(shared->streams, 0, 0, item.pathPackedSav, item.outUnpackedText, item.bufferSize, &header);
+			item.unpackedSize = header.realSize;
+		});
+
+		for (unsigned int i = 0; i < itemCount; ++i)
+		{
+			if (items[i].errcode)
+				return items[i].errcode;
+		}
+		return 0;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+// Writes size zero bytes at offset without allocating them
+int WriteZeros(SavFile &file, unsigned int offset, unsigned int size)
+{
+	static const unsigned char zeros[4096] = { 0 };
+	while (size > 0)
+	{
+		unsigned int count = size < sizeof(zeros) ? size : sizeof(zeros);
+		if (file.WriteAt(offset, zeros, count) != 0)
+			return ERR_WRITE;
+		offset += count;
+		size -= count;
+	}
 	return 0;
 }
 
-__declspec(dllexport) int Repack(const char *outputPath, const char *xmlData, unsigned int dataSize)
+// Threads worth compressing dataSize bytes on: one per core, but no more than there are pieces
+unsigned int RepackThreadCount(unsigned int dataSize)
 {
-	const unsigned char *data = reinterpret_cast<const unsigned char *>(xmlData);
+	unsigned int threadCount = std::thread::hardware_concurrency();
+	unsigned int pieceCount = (dataSize + SAVDEFLATE_PIECESIZE - 1) / SAVDEFLATE_PIECESIZE;
+	if (threadCount > pieceCount)
+		threadCount = pieceCount;
+	return threadCount > 0 ? threadCount : 1;
+}
 
-	//Compress
-	unsigned int l = EZ_COMPRESSMAXDESTLENGTH(dataSize);
-	unsigned char *compBuffer = new unsigned char[l];
-	ezcompress(compBuffer, (long *)&l, data, dataSize);
+void InitHeader(header_s *header, unsigned int compressedSize, unsigned int realSize, unsigned int hash)
+{
+	header->u1 = 21;
+	header->u2 = 860693325;
+	header->u3 = 0;
+	header->u4 = 860700740;
+	header->u5 = 1079398965;
+	header->compressedSize = compressedSize;
+	header->realSize = realSize;
+	header->hash = hash;
+}
 
-	//Prepare header
-	header_s header;
-	header.u1 = 21;
-	header.u2 = 860693325;
-	header.u3 = 0;
-	header.u4 = 860700740;
-	header.u5 = 1079398965;
-	header.compressedSize = l;
-	header.realSize = dataSize;
-	header.hash = 0;
-
-	//Calculate hash
-	crc32tab();
-	header.hash = crc32jam(compBuffer, l);
-
-	//Create new file
-	FILE *file;
-	fopen_s(&file, outputPath, "wb");
-	if (!file)
+// Writes a packed save from its header and compressed stream, padded to SAVESIZE
+int WritePackedSave(const char *outputPath, const header_s *header, const unsigned char *stream)
+{
+	SavFile file;
+	if (file.OpenWrite(outputPath) != 0)
 	{
 		printf("Error: Could not open file %s for writing.\n", outputPath);
-		delete[]compBuffer;
 		return ERR_WRITE;
 	}
 
-	//Write header
-	fwrite(&header, sizeof(header_s), 1, file);
+	unsigned int l = header->compressedSize;
+	int errcode = file.WriteAt(0, header, sizeof(header_s));
+	if (!errcode)
+		errcode = file.WriteAt(sizeof(header_s), stream, l);
+	if (!errcode && sizeof(header_s) + l < SAVESIZE)
+		errcode = WriteZeros(file, sizeof(header_s) + l, SAVESIZE - sizeof(header_s) - l);
+
+	if (file.Close() != 0 && !errcode)
+		errcode = ERR_WRITE;
+	return errcode;
+}
+
+// The most compressed bytes RepackEx may write for budget: the whole save after its header unless less is asked for
+unsigned int RepackBudget(unsigned int budget)
+{
+	if (budget == 0 || budget > SAVESIZE - sizeof(header_s))
+		return SAVESIZE - sizeof(header_s);
+	return budget;
+}
 
-	//Write compressed data
-	fwrite(compBuffer, l, 1, file);
+// Compresses data with one profile's settings in an arena of context's, writing the save if it fits in budget.
+// With saves, an edit of its checkpoint text keeps that save's payload up to just before the edit, if it was
+// compressed at least as hard as the profile asks; if that doesn't fit, all of data is compressed.
+// The save written is then remembered in saves.
+int RepackWith(	SavContext &context,
+				SavSaveCache *saves,
+				const char *outputPath,
+				const char *xmlData,
+				unsigned int dataSize,
+				int profile,
+				unsigned int budget)
+{
+	SavArena *arena = context.streams.AcquireArena();
+	if (!arena)
+		return ERR_MEMORY;
 
-	//Write padding
-	unsigned int paddingSize = SAVESIZE - sizeof(header_s) - l;
-	unsigned char *padding = new unsigned char[paddingSize];
-	memset(padding, 0, paddingSize);
-	fwrite(padding, paddingSize, 1, file);
+	const unsigned char *data = reinterpret_cast<const unsigned char *>(xmlData);
+	const RepackProfile &settings = RepackProfiles[profile];
+	unsigned char *stream = 0;
+	unsigned int streamSize = 0;
+	std::vector<SavAccessPoint> points;
+	SavDeflateResume resume;
+	int errcode = saves ? saves->checkpoint.Find(saves->packed, saves->access, *arena, data, dataSize, &resume, &points) : ERR_NOTCACHED;
+	if (!errcode && !CanResume(resume, settings.level, settings.strategy))
+		errcode = ERR_NOTCACHED;
+	if (!errcode)
+		errcode = ParallelDeflate(data, dataSize, settings.level, settings.strategy, context, *arena, budget, &stream, &streamSize, &resume, &points);
+	if (errcode == ERR_NOTCACHED || errcode == ERR_TOOLARGE)
+	{
+		points.clear();
+		errcode = ParallelDeflate(data, dataSize, settings.level, settings.strategy, context, *arena, budget, &stream, &streamSize, 0, &points);
+	}
+	if (!errcode)
+	{
+		header_s header;
+		InitHeader(&header, streamSize, dataSize, crc32jam(stream, streamSize));
+		errcode = WritePackedSave(outputPath, &header, stream);
 
-	//Finish
-	fclose(file);
-	delete[]compBuffer;
-	delete[]padding;
-	return 0;
+		//So repacking this text again writes these bytes back
+		if (!errcode && saves)
+		{
+			saves->packed.Remember(&header, stream);
+			saves->access.Remember(&header, points, data);
+		}
+	}
+
+	context.streams.ReleaseArena(arena);
+	return errcode;
 }
 
-__declspec(dllexport) int Validate(const char *path)
+// If xmlData is exactly the text of a save in saves, and that save's payload fits in budget, writes its
+// original header and payload back rather than compressing it again. Returns false, writing nothing, if not.
+bool RepackUnchanged(	SavContext &context,
+						SavSaveCache &saves,
+						const char *outputPath,
+						const char *xmlData,
+						unsigned int dataSize,
+						unsigned int budget,
+						int *outErrcode)
 {
-	unsigned char *data = 0;
-	unsigned int dataSize = 0;
-	int errcode = ReadFile(path, &data, &dataSize, 64);
+	SavArena *arena = context.streams.AcquireArena();
+	if (!arena)
+		return false;
 
-	//Header
-	header_s *header = (header_s *)data;
-	if (header->u1 != 21)
+	const unsigned char *data = reinterpret_cast<const unsigned char *>(xmlData);
+	header_s header;
+	unsigned char *compressed = 0;
+	//The checkpoint text is compared as it is, with no payload to inflate
+	bool found = saves.checkpoint.Matches(data, dataSize, &header) && saves.packed.Copy(&header, *arena, &compressed) == 0;
+	if (!found)
 	{
-		return ERR_FORMAT;
+		arena->Reset();
+		found = saves.packed.Find(context.streams, *arena, data, dataSize, &header, &compressed) == 0;
+	}
+	bool unchanged = found && header.compressedSize <= budget;
+	if (unchanged)
+		*outErrcode = WritePackedSave(outputPath, &header, compressed);
+
+	context.streams.ReleaseArena(arena);
+	return unchanged;
+}
+
+// RepackEx on context's threads and streams, with saves, if given, for the saves it may write back or resume from
+int RepackContext(	SavContext &context,
+					SavSaveCache *saves,
+					const char *outputPath,
+					const char *xmlData,
+					unsigned int dataSize,
+					int profile,
+					unsigned int budget)
+{
+	if (profile < SAVPROFILE_FASTEST || profile > SAVPROFILE_SMALLEST)
+		return ERR_ARGUMENT;
+	budget = RepackBudget(budget);
+
+	int errcode = 0;
+	if (saves && RepackUnchanged(context, *saves, outputPath, xmlData, dataSize, budget, &errcode))
+		return errcode;
+
+	//Compressed in memory, so nothing is written unless it fits
+	for (; profile <= SAVPROFILE_SMALLEST; ++profile)
+	{
+		errcode = RepackWith(context, saves, outputPath, xmlData, dataSize, profile, budget);
+		if (errcode != ERR_TOOLARGE)
+			return errcode;
+	}
+	return ERR_TOOLARGE;
+}
+
+//Context Repack, RepackEx and PlanRepack share, made by the first of them. Never deleted: its threads
+//would be joined while the library unloads, which deadlocks on Windows.
+std::mutex sharedContextLock;
+SavContext *sharedContext = 0;
+bool sharedContextBusy = false;
+
+// The shared context, so saving doesn't start and join a thread per core each time, or while another call
+// is using it, a context of the caller's own. Null if neither can be made.
+class SharedContextLease
+{
+public:
+	explicit SharedContextLease(unsigned int dataSize) : context(0), owned(false)
+	{
+		{
+			std::lock_guard<std::mutex> guard(sharedContextLock);
+			if (!sharedContext)
+				sharedContext = NewContext(0);
+			if (sharedContext && !sharedContextBusy)
+			{
+				sharedContextBusy = true;
+				context = sharedContext;
+				return;
+			}
+		}
+		context = NewContext(RepackThreadCount(dataSize));
+		owned = true;
+	}
+
+	~SharedContextLease()
+	{
+		if (owned)
+		{
+			delete context;
+			return;
+		}
+		if (context)
+		{
+			std::lock_guard<std::mutex> guard(sharedContextLock);
+			sharedContextBusy = false;
+		}
+	}
+
+	SavContext *Get() const { return context; }
+
+private:
+	SharedContextLease(const SharedContextLease &);
+	SharedContextLease &operator=(const SharedContextLease &);
+
+	SavContext *context;
+	bool owned; //A context of this call's own, because the shared one was busy or couldn't be made
+};
+
+DDSAVELIB_API int Repack(const char *outputPath, const char *xmlData, unsigned int dataSize)
+{
+	try
+	{
+		//Compressed in memory first, stopping as soon as it can't fit, so an oversized save is never written
+		SharedContextLease lease(dataSize);
+		SavContext *context = lease.Get();
+		if (!context)
+			return ERR_MEMORY;
+		return RepackWith(*context, 0, outputPath, xmlData, dataSize, SAVPROFILE_BALANCED, RepackBudget(0));
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int RepackEx(const char *outputPath, const char *xmlData, unsigned int dataSize, int profile, unsigned int budget)
+{
+	try
+	{
+		SharedContextLease lease(dataSize);
+		SavContext *context = lease.Get();
+		if (!context)
+			return ERR_MEMORY;
+		return RepackContext(*context, 0, outputPath, xmlData, dataSize, profile, budget);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavDocumentRepack(const SavDocument *document, const char *outputPath, int profile, unsigned int budget)
+{
+	try
+	{
+		SharedContextLease lease(document->size);
+		SavContext *context = lease.Get();
+		if (!context)
+			return ERR_MEMORY;
+		return RepackContext(*context, &document->saves, outputPath, document->text, document->size, profile, budget);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavDocumentRepackEdit(const SavDocument *document, const char *outputPath, const unsigned char *data, size_t size, int profile, unsigned int budget)
+{
+	try
+	{
+		if (size > 0xFFFFFFFF)
+			return ERR_TOOLARGE;
+		SharedContextLease lease((unsigned int)size);
+		SavContext *context = lease.Get();
+		if (!context)
+			return ERR_MEMORY;
+		return RepackContext(*context, &document->saves, outputPath, reinterpret_cast<const char *>(data), (unsigned int)size, profile, budget);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int RepackBytes(const char *outputPath, const unsigned char *data, size_t size, int profile, unsigned int budget)
+{
+	try
+	{
+		//The header only has room for a 32-bit size, and nothing near that fits anyway
+		if (size > 0xFFFFFFFF)
+			return ERR_TOOLARGE;
+		return RepackEx(outputPath, reinterpret_cast<const char *>(data), (unsigned int)size, profile, budget);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int PlanRepack(const char *xmlData, unsigned int dataSize, int profile, unsigned int budget, SavRepackPlan *outPlan)
+{
+	try
+	{
+		if (profile < SAVPROFILE_FASTEST || profile > SAVPROFILE_SMALLEST)
+			return ERR_ARGUMENT;
+		budget = RepackBudget(budget);
+
+		const unsigned char *data = reinterpret_cast<const unsigned char *>(xmlData);
+		SharedContextLease lease(dataSize);
+		if (!lease.Get())
+			return ERR_MEMORY;
+		SavContext &context = *lease.Get();
+		SavArena arena;
+
+		for (; profile <= SAVPROFILE_SMALLEST; ++profile)
+		{
+			const RepackProfile &settings = RepackProfiles[profile];
+			unsigned long long compressedSize = 0;
+			int errcode = MeasureParallelDeflate(data, dataSize, settings.level, settings.strategy, context, arena, &compressedSize);
+			arena.Reset();
+			if (errcode)
+				return errcode;
+
+			outPlan->profile = profile;
+			outPlan->compressedSize = compressedSize;
+			outPlan->headroom = (long long)budget - (long long)compressedSize;
+			if (compressedSize <= budget)
+				return 0;
+		}
+		return ERR_TOOLARGE;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavContextOpen(unsigned int threadCount, SavContext **outContext)
+{
+	try
+	{
+		*outContext = NewContext(threadCount);
+		return *outContext ? 0 : ERR_MEMORY;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API void SavContextClose(SavContext *context)
+{
+	delete context;
+}
+
+DDSAVELIB_API int SavContextUnpack(SavContext *context, const char *pathPackedSav, char *outUnpackedText, unsigned int bufferSize)
+{
+	try
+	{
+		//A context is for converting saves back and forth, so the text is kept for repacking an edit of it
+		header_s header;
+		int errcode = UnpackFile(context->streams, &context->saves.packed, &context->saves.access, pathPackedSav, outUnpackedText, bufferSize, &header);
+		if (!errcode)
+			context->saves.checkpoint.Remember(&header, reinterpret_cast<const unsigned char *>(outUnpackedText));
+		return errcode;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavContextUnpackRange(SavContext *context, const char *pathPackedSav, unsigned int offset, unsigned int size, char *outText)
+{
+	try
+	{
+		return UnpackRangeFile(context->streams, &context->saves.access, pathPackedSav, offset, size, outText);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavContextUnpackSpans(	SavContext *context,
+										const char *pathPackedSav,
+										const char *const *paths,
+										unsigned int pathCount,
+										char *outUnpackedText,
+										unsigned int bufferSize,
+										SavValueSpan *outSpans)
+{
+	try
+	{
+		SavMappedFile packedFile;
+		int errcode = MapPackedSave(pathPackedSav, packedFile);
+		if (errcode)
+			return errcode;
+		if (((const header_s *)packedFile.GetData())->realSize > bufferSize)
+			return ERR_BUFFERSIZE;
+
+		return UnpackIndexedMapped(context->streams, &context->saves.access, pathPackedSav, packedFile.GetData(), paths, pathCount, outUnpackedText, outSpans);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavContextExtractPawn(	SavContext *context,
+										const char *pathPackedSav,
+										const SavPawnConfig *config,
+										unsigned int slot,
+										SavPawnValue *outValues,
+										unsigned int capacity,
+										unsigned int *outCount)
+{
+	try
+	{
+		return ExtractPawnWith(context->streams, &context->saves.access, pathPackedSav, config, slot, outValues, capacity, outCount);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavContextRepack(SavContext *context, const char *outputPath, const char *xmlData, unsigned int dataSize, int profile, unsigned int budget)
+{
+	try
+	{
+		//The text is only kept until it has been repacked
+		int errcode = RepackContext(*context, &context->saves, outputPath, xmlData, dataSize, profile, budget);
+		if (!errcode)
+			context->saves.checkpoint.Forget();
+		return errcode;
 	}
-	else return 0;
-}
\ No newline at end of file
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int Validate(const char *path)
+{
+	try
+	{
+		//Only the header is read, so checking many saves touches one page of each
+		header_s header;
+		return ReadHeader(path, &header);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int Verify(const char *path)
+{
+	try
+	{
+		SavMappedFile file;
+		int errcode = file.Open(path);
+		if (errcode)
+			return errcode;
+
+		const unsigned char *data = file.GetData();
+		errcode = CheckPackedSave(data, file.GetSize());
+
+		//Constant header fields
+		const header_s *header = (const header_s *)data;
+		if (!errcode &&
+			(header->u2 != 860693325 || header->u3 != 0 || header->u4 != 860700740 || header->u5 != 1079398965))
+		{
+			errcode = ERR_FORMAT;
+		}
+
+		//zlib framing: a deflate header without a preset dictionary, and room for the Adler-32 trailer.
+		//The trailer is a checksum of the unpacked text, so only Unpack can check its value.
+		if (!errcode)
+		{
+			const unsigned char *compressed = &data[sizeof(header_s)];
+			if (header->compressedSize < ZLIB_MINSIZE ||
+				(compressed[0] & 0x0F) != 8 ||
+				(compressed[0] >> 4) > 7 ||
+				(compressed[1] & 0x20) != 0 ||
+				((compressed[0] << 8) | compressed[1]) % 31 != 0)
+			{
+				errcode = ERR_DATA;
+			}
+		}
+
+		return errcode;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavXmlReaderOpen(const char *text, unsigned int size, SavXmlReader **outReader)
+{
+	try
+	{
+		*outReader = new (std::nothrow) SavXmlReader(text, size);
+		return *outReader ? 0 : ERR_MEMORY;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavXmlReaderNext(SavXmlReader *reader, SavXmlEvent *outEvent)
+{
+	try
+	{
+		return reader->Next(outEvent);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API void SavXmlReaderClose(SavXmlReader *reader)
+{
+	delete reader;
+}
+
+DDSAVELIB_API int PatchXml(const char *text, unsigned int size, const SavXmlEdit *edits, unsigned int editCount, char *outText, unsigned int outCapacity, unsigned int *outSize)
+{
+	try
+	{
+		std::vector<const char *> paths(editCount);
+		std::vector<const char *> values(editCount);
+		for (unsigned int i = 0; i < editCount; ++i)
+		{
+			paths[i] = edits[i].path;
+			values[i] = edits[i].value;
+		}
+
+		std::vector<SavValueSpan> spans(editCount);
+		SavPathMatcher matcher(paths.data(), editCount);
+		int errcode = matcher.Resolve(text, size, spans.data());
+		if (errcode)
+			return errcode;
+
+		//Edits of elements that aren't there are skipped, as writing into the tree would
+		unsigned int found = 0;
+		for (unsigned int i = 0; i < editCount; ++i)
+		{
+			if (spans[i].offset == SAVPATH_NOTFOUND)
+				continue;
+			spans[found] = spans[i];
+			values[found] = values[i];
+			++found;
+		}
+
+		return PatchText(text, size, spans.data(), values.data(), found, outText, outCapacity, outSize);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavBinaryFromXml(const char *text, unsigned int size, SavBinary **outBinary)
+{
+	try
+	{
+		*outBinary = 0;
+		SavBinary *binary = new (std::nothrow) SavBinary();
+		if (!binary)
+			return ERR_MEMORY;
+		int errcode = binary->Build(text, size);
+		if (errcode)
+		{
+			delete binary;
+			return errcode;
+		}
+		*outBinary = binary;
+		return 0;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int UnpackBinary(const char *pathPackedSav, SavBinary **outBinary)
+{
+	try
+	{
+		*outBinary = 0;
+		SavMappedFile packedFile;
+		int errcode = MapPackedSave(pathPackedSav, packedFile);
+		if (errcode)
+			return errcode;
+
+		//Left uninitialized, since inflating writes every byte
+		unsigned int size = ((const header_s *)packedFile.GetData())->realSize;
+		std::unique_ptr<char[]> text(new (std::nothrow) char[size > 0 ? size : 1]);
+		if (!text)
+			return ERR_MEMORY;
+
+		SavStreamCache streams;
+		errcode = UnpackMapped(streams, 0, 0, packedFile.GetData(), text.get(), size);
+		if (errcode)
+			return errcode;
+
+		return SavBinaryFromXml(text.get(), size, outBinary);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavBinaryGetXmlSize(const SavBinary *binary, unsigned int *outSize)
+{
+	try
+	{
+		*outSize = binary->GetXmlSize();
+		return 0;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavBinaryToXml(const SavBinary *binary, char *outText, unsigned int capacity)
+{
+	try
+	{
+		unsigned int size = 0;
+		return binary->ToXml(outText, capacity, &size);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavBinaryGetMemorySize(const SavBinary *binary, unsigned int *outSize)
+{
+	try
+	{
+		*outSize = (unsigned int)binary->GetMemorySize();
+		return 0;
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavBinaryFind(const SavBinary *binary, const char *path, SavBinaryRef *outRef)
+{
+	try
+	{
+		return binary->Find(path, outRef);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavBinaryGetInt(const SavBinary *binary, SavBinaryRef ref, long long *outValue)
+{
+	try
+	{
+		return binary->GetInt(ref, outValue);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API int SavBinaryGetFloat(const SavBinary *binary, SavBinaryRef ref, float *outValue)
+{
+	try
+	{
+		return binary->GetFloat(ref, outValue);
+	}
+	catch (...)
+	{
+		return ERR_MEMORY;
+	}
+}
+
+DDSAVELIB_API void SavBinaryClose(SavBinary *binary)
+{
+	delete binary;
+}
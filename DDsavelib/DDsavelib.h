@@ -1,6 +1,235 @@
 #pragma once
 
-extern "C" __declspec(dllexport) int Unpack(const char *pathPackedSav, char *outUnpackedText);
-extern "C" __declspec(dllexport) int Repack(const char *outputPath, const char *xmlData, unsigned int dataSize);
+#include <stddef.h>
 
-extern "C" __declspec(dllexport) int Validate(const char *path);
+//Exports keep C names on every platform; the Linux build hides everything else
+#ifdef _WIN32
+#define DDSAVELIB_API extern "C" __declspec(dllexport)
+#else
+#define DDSAVELIB_API extern "C" __attribute__((visibility("default")))
+#endif
+
+// Returned for an argument outside what a call accepts, like an unknown profile or slot,
+// so it isn't mistaken for a file or zlib stream that couldn't be read
+#define SAVERR_ARGUMENT 10
+
+// Receives one window of unpacked text; return nonzero to stop unpacking
+typedef int (*UnpackCallback)(const char *data, unsigned int size, void *userData);
+
+// A run of bytes inside the unpacked text. Not null-terminated, and entities like &amp; are left as written.
+struct SavXmlSpan
+{
+	const char *data;
+	unsigned int size;
+};
+
+#define SAVXML_EOF 0
+#define SAVXML_START 1
+#define SAVXML_END 2
+
+// One element boundary from a SavXmlReader. Spans point into the text the reader was opened on;
+// attributes an element doesn't have are empty. A self-closing element gives a START with isEmpty set,
+// immediately followed by its END.
+struct SavXmlEvent
+{
+	int kind; //SAVXML_START, SAVXML_END, or SAVXML_EOF once the root element has closed
+	int isEmpty;
+	unsigned int depth; //0 for the root element
+	unsigned int offset; //Byte offset of the tag's '<'
+	unsigned int size; //Length of the tag up to and including its '>'
+	unsigned int count; //Parsed count attribute of arrays, 0 when absent
+	SavXmlSpan tag; //class, array, u32, ...
+	SavXmlSpan name;
+	SavXmlSpan type;
+	SavXmlSpan value;
+	SavXmlSpan attributes; //Every attribute of a START, for the few elements like vector3 with others
+};
+
+struct SavXmlReader;
+
+// One save for UnpackBatch and where its text goes: to callback a window at a time, as with UnpackStream,
+// or if callback is null, into outUnpackedText as with UnpackToBuffer.
+struct SavBatchItem
+{
+	const char *pathPackedSav;
+	char *outUnpackedText;
+	unsigned int bufferSize;
+	UnpackCallback callback;
+	void *userData;
+	int errcode; //Set by UnpackBatch to what unpacking this save returned
+	unsigned int unpackedSize; //Set by UnpackBatch to the save's realSize, or 0 if it couldn't be read
+};
+
+// Replaces the value attribute of the element at path. Paths are names separated by '/', starting
+// below the root element; #N stands for the Nth child, for unnamed array entries.
+// The value is written as given, so it must already be escaped.
+struct SavXmlEdit
+{
+	const char *path;
+	const char *value;
+};
+
+// Marks a path that matched no element, or an element without a value attribute
+#define SAVPATH_NOTFOUND 0xFFFFFFFF
+
+// Where an element's value attribute sits in the unpacked text, in bytes
+struct SavValueSpan
+{
+	unsigned int offset;
+	unsigned int size;
+};
+
+struct SavBinary;
+
+// A value inside a SavBinary: an element, or the Nth item of an array of unnamed scalars
+struct SavBinaryRef
+{
+	unsigned int node;
+	unsigned int item; //SAVBINARY_NOITEM for an element
+};
+
+#define SAVBINARY_NOITEM 0xFFFFFFFF
+
+struct SavPawnConfig;
+
+// Pawn slots a SavPawnConfig has entries for: the main pawn, then the two others
+#define SAVPAWN_SLOTCOUNT 3
+// Letters in a pawn's name, which is padded with zeros
+#define SAVPAWN_NAMELENGTH 25
+
+// Flags of a SavPawnConfig entry
+#define SAVPAWN_NAME 1 //The element is an array of SAVPAWN_NAMELENGTH letters holding the pawn's name
+#define SAVPAWN_WRITEONLY 2 //The element is written when exporting, but never read
+
+// One value ExtractPawn read
+struct SavPawnValue
+{
+	unsigned int entry; //The entry it belongs to, counting the slot's SavPawnConfigAdd calls from 0
+	long long value; //The element's value attribute as an integer; a name gives one per letter, in order
+};
+
+// Compression settings for RepackEx, from quickest to smallest output
+#define SAVPROFILE_FASTEST 0
+#define SAVPROFILE_BALANCED 1
+#define SAVPROFILE_SMALLEST 2
+
+// What PlanRepack found, before anything is written
+struct SavRepackPlan
+{
+	int profile; //The profile RepackEx would write with, or the strongest one tried if none fits
+	unsigned long long compressedSize; //Exact size of that profile's compressed data
+	long long headroom; //Budget left over; negative by how much the data is too large
+};
+
+struct SavContext;
+struct SavDocument;
+
+DDSAVELIB_API int Unpack(const char *pathPackedSav, char *outUnpackedText);
+// Reads only the header of a packed save, giving the exact buffer size UnpackToBuffer needs
+DDSAVELIB_API int GetUnpackedSize(const char *pathPackedSav, unsigned int *outSize);
+// Like Unpack, but fails with ERR_BUFFERSIZE instead of writing past bufferSize bytes
+DDSAVELIB_API int UnpackToBuffer(const char *pathPackedSav, char *outUnpackedText, unsigned int bufferSize);
+// Unpacks into memory DDsavelib allocates and owns, so the caller can read the text in place instead of copying
+// it out. The text is exactly the save's realSize bytes, UTF-8, and not null-terminated.
+DDSAVELIB_API int UnpackDocument(const char *pathPackedSav, SavDocument **outDocument);
+// The document's text stays valid, and unchanged, until SavDocumentClose
+DDSAVELIB_API int SavDocumentGetText(const SavDocument *document, const char **outText, unsigned int *outSize);
+// RepackEx on the document's text, without it leaving DDsavelib. The text is the save it was unpacked from,
+// so that save's bytes are written back rather than compressed again.
+DDSAVELIB_API int SavDocumentRepack(const SavDocument *document, const char *outputPath, int profile, unsigned int budget);
+// RepackBytes for an edited copy of the document's text, which keeps the save's compressed bytes up to shortly
+// before the first change and only compresses the rest. One call at a time per document.
+DDSAVELIB_API int SavDocumentRepackEdit(const SavDocument *document, const char *outputPath, const unsigned char *data, size_t size, int profile, unsigned int budget);
+DDSAVELIB_API void SavDocumentClose(SavDocument *document);
+// Unpacks in windows of windowSize bytes (0 for the default of 64 KB), so the whole text is never in memory at once
+DDSAVELIB_API int UnpackStream(const char *pathPackedSav, unsigned int windowSize, UnpackCallback callback, void *userData);
+// Like UnpackToBuffer, and also fills outSpans[i] with where the value attribute of paths[i] is in the text
+// (see PatchXml for the path syntax), or SAVPATH_NOTFOUND. The spans are cached next to the save in
+// pathPackedSav + ".idx", so unpacking the same save again with the same paths skips the scan. The whole text is
+// always unpacked; SavContextUnpackSpans can inflate only the text under the spans.
+DDSAVELIB_API int UnpackIndexed(const char *pathPackedSav, const char *const *paths, unsigned int pathCount, char *outUnpackedText, unsigned int bufferSize, SavValueSpan *outSpans);
+// Unpacks the size bytes of text from offset on into outText, failing with ERR_BUFFERSIZE if they run past the end.
+// The text up to offset is inflated too; SavContextUnpackRange can skip most of that.
+DDSAVELIB_API int UnpackRange(const char *pathPackedSav, unsigned int offset, unsigned int size, char *outText);
+// The elements holding a pawn's parameters in each slot, as the sav section of config.xml compiles to: entries that
+// a condition keeps away from a slot are just not added to it, and write-only ones are added with SAVPAWN_WRITEONLY.
+DDSAVELIB_API int SavPawnConfigOpen(SavPawnConfig **outConfig);
+// Adds the element at path, in the syntax PatchXml uses, as the next entry of slot, with SAVPAWN_ flags.
+// Fails with SAVERR_ARGUMENT if slot isn't below SAVPAWN_SLOTCOUNT, or ERR_MEMORY.
+DDSAVELIB_API int SavPawnConfigAdd(SavPawnConfig *config, unsigned int slot, const char *path, int flags);
+DDSAVELIB_API void SavPawnConfigClose(SavPawnConfig *config);
+// Reads the pawn in slot out of a packed save in one call, finding its elements like UnpackIndexed does but only
+// handing back their values. outValues gets them in entry order: one for each element found, or for a name one
+// for each letter before its first 0. Write-only entries are skipped. capacity is always enough if it is one
+// for each entry of the slot, or SAVPAWN_NAMELENGTH for a name; if not, fails with ERR_BUFFERSIZE.
+// Fails with ERR_FORMAT if a value isn't a number, or SAVERR_ARGUMENT if slot isn't below SAVPAWN_SLOTCOUNT.
+DDSAVELIB_API int ExtractPawn(const char *pathPackedSav, const SavPawnConfig *config, unsigned int slot, SavPawnValue *outValues, unsigned int capacity, unsigned int *outCount);
+// Unpacks every item's save on threadCount threads (0 for one per core), and returns 0 if all of them unpacked,
+// or else the first failing item's errcode. Callbacks for different items can run at the same time,
+// though each item's windows arrive in order on one thread. windowSize is as for UnpackStream.
+DDSAVELIB_API int UnpackBatch(SavBatchItem *items, unsigned int itemCount, unsigned int threadCount, unsigned int windowSize);
+// Fails with ERR_TOOLARGE, without touching the file, if the compressed data doesn't fit after the header.
+// The whole text is always compressed; SavContextRepack and the SavDocument calls can skip some or all of that.
+DDSAVELIB_API int Repack(const char *outputPath, const char *xmlData, unsigned int dataSize);
+// Like Repack, compressing with a SAVPROFILE_ profile, but only writes the file if the compressed data fits in
+// budget bytes (0, or anything larger, for all of the save after its header). If it doesn't, each stronger
+// profile is tried in turn, and if none fits, fails with ERR_TOOLARGE and leaves the file untouched.
+// Fails with SAVERR_ARGUMENT for a profile that isn't a SAVPROFILE_ one.
+DDSAVELIB_API int RepackEx(const char *outputPath, const char *xmlData, unsigned int dataSize, int profile, unsigned int budget);
+// RepackEx for exactly size bytes of UTF-8 text, which needn't be null-terminated
+DDSAVELIB_API int RepackBytes(const char *outputPath, const unsigned char *data, size_t size, int profile, unsigned int budget);
+// Compresses like RepackEx without writing anything, and fills outPlan with the profile it would settle on and
+// that profile's exact compressed size. Returns ERR_TOOLARGE when no profile fits, with the strongest one's plan.
+DDSAVELIB_API int PlanRepack(const char *xmlData, unsigned int dataSize, int profile, unsigned int budget, SavRepackPlan *outPlan);
+
+// Keeps zlib streams and compression threads (threadCount, or 0 for one per core) alive from one save to the
+// next, so converting many saves doesn't set up and tear down a stream each time. One call at a time per context.
+// Returns ERR_MEMORY if the context or its threads can't be made.
+DDSAVELIB_API int SavContextOpen(unsigned int threadCount, SavContext **outContext);
+DDSAVELIB_API void SavContextClose(SavContext *context);
+// UnpackToBuffer, UnpackRange, ExtractPawn and RepackEx on a context's streams and threads. The context remembers
+// the last few saves SavContextUnpack and SavContextRepack went through, and text exactly as one of them gives is
+// not compressed again: that save's bytes are written. It also notes where in each save it unpacks inflating can
+// start, so SavContextUnpackRange enters a save it has seen at an access point within a megabyte before offset,
+// instead of inflating everything up to it. An edited copy of the text SavContextUnpack last gave out keeps its
+// compressed bytes up to shortly before the first change; the context keeps its own copy of that text, unless it
+// is larger than 64 MB, until a SavContextRepack writes a save.
+DDSAVELIB_API int SavContextUnpack(SavContext *context, const char *pathPackedSav, char *outUnpackedText, unsigned int bufferSize);
+DDSAVELIB_API int SavContextUnpackRange(SavContext *context, const char *pathPackedSav, unsigned int offset, unsigned int size, char *outText);
+// Like UnpackIndexed, but partial: if the spans are cached and the context has seen the save, only the text under
+// them is inflated, and the rest of the buffer is left as it was. Only the text under the found spans is certain.
+DDSAVELIB_API int SavContextUnpackSpans(SavContext *context, const char *pathPackedSav, const char *const *paths, unsigned int pathCount, char *outUnpackedText, unsigned int bufferSize, SavValueSpan *outSpans);
+// ExtractPawn with SavContextUnpackSpans, so reading pawns out of a save the context has seen is quick
+DDSAVELIB_API int SavContextExtractPawn(SavContext *context, const char *pathPackedSav, const SavPawnConfig *config, unsigned int slot, SavPawnValue *outValues, unsigned int capacity, unsigned int *outCount);
+DDSAVELIB_API int SavContextRepack(SavContext *context, const char *outputPath, const char *xmlData, unsigned int dataSize, int profile, unsigned int budget);
+
+DDSAVELIB_API int Validate(const char *path);
+// Integrity check without inflating: header constants, compressedSize, checksum and zlib framing
+DDSAVELIB_API int Verify(const char *path);
+
+// Pull parser over unpacked text, which must stay alive and unchanged until the reader is closed
+DDSAVELIB_API int SavXmlReaderOpen(const char *text, unsigned int size, SavXmlReader **outReader);
+DDSAVELIB_API int SavXmlReaderNext(SavXmlReader *reader, SavXmlEvent *outEvent);
+DDSAVELIB_API void SavXmlReaderClose(SavXmlReader *reader);
+
+// Copies unpacked text to outText with only the edited value attributes rewritten.
+// *outSize gets the patched length; size plus the total length of the new values is always enough room.
+// Edits whose element doesn't exist or has no value attribute are skipped, like an export into the tree skips them.
+DDSAVELIB_API int PatchXml(const char *text, unsigned int size, const SavXmlEdit *edits, unsigned int editCount, char *outText, unsigned int outCapacity, unsigned int *outSize);
+
+// Converts unpacked text into a compact typed tree, which SavBinaryToXml turns back into the exact same text.
+// Fails with ERR_FORMAT if the text isn't one tag per line, the layout every save is written in.
+DDSAVELIB_API int SavBinaryFromXml(const char *text, unsigned int size, SavBinary **outBinary);
+// Unpacks a save straight into a SavBinary
+DDSAVELIB_API int UnpackBinary(const char *pathPackedSav, SavBinary **outBinary);
+DDSAVELIB_API int SavBinaryGetXmlSize(const SavBinary *binary, unsigned int *outSize);
+// Like UnpackToBuffer, fails with ERR_BUFFERSIZE if the text doesn't fit in capacity bytes
+DDSAVELIB_API int SavBinaryToXml(const SavBinary *binary, char *outText, unsigned int capacity);
+DDSAVELIB_API int SavBinaryGetMemorySize(const SavBinary *binary, unsigned int *outSize);
+// Finds a value by path, in the syntax PatchXml uses. Fails with ERR_PATH if there is no such element.
+DDSAVELIB_API int SavBinaryFind(const SavBinary *binary, const char *path, SavBinaryRef *outRef);
+// Reads an integer or bool value; fails with ERR_FORMAT for other types
+DDSAVELIB_API int SavBinaryGetInt(const SavBinary *binary, SavBinaryRef ref, long long *outValue);
+// Reads an f32 value; fails with ERR_FORMAT for other types
+DDSAVELIB_API int SavBinaryGetFloat(const SavBinary *binary, SavBinaryRef ref, float *outValue);
+DDSAVELIB_API void SavBinaryClose(SavBinary *binary);
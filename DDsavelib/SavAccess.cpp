@@ -0,0 +1,202 @@
+// SavAccess.cpp : Access points for inflating part of a save's text without the rest.
+//
+
+#include "SavAccess.h"
+#include "SavArena.h"
+#include "SavContext.h"
+#include "easyzlib.h"
+
+#include <new>
+#include <string.h>
+
+//Text before a range is inflated into a window of this size and thrown away
+#define SAVACCESS_WINDOWSIZE (64 * 1024)
+
+namespace
+{
+	//Points near the start have less than a whole window of text before them
+	unsigned int WindowSize(const SavAccessPoint &point)
+	{
+		return point.textOffset < EZ_DICTIONARYSIZE ? point.textOffset : EZ_DICTIONARYSIZE;
+	}
+
+	// Index of the closest of points at or before offset
+	size_t FindPoint(const std::vector<SavAccessPoint> &points, unsigned int offset)
+	{
+		size_t i = 0;
+		while (i + 1 < points.size() && points[i + 1].textOffset <= offset)
+			++i;
+		return i;
+	}
+}
+
+SavAccessCache::Entry *SavAccessCache::FindEntry(const header_s *header)
+{
+	for (Entry &entry : entries)
+	{
+		if (entry.lastUsed != 0 &&
+			entry.header.hash == header->hash &&
+			entry.header.realSize == header->realSize &&
+			entry.header.compressedSize == header->compressedSize)
+		{
+			return &entry;
+		}
+	}
+	return 0;
+}
+
+bool SavAccessCache::Has(const header_s *header)
+{
+	return FindEntry(header) != 0;
+}
+
+bool SavAccessCache::Copy(const header_s *header, unsigned int offset, std::vector<SavAccessPoint> *outPoints)
+{
+	Entry *entry = FindEntry(header);
+	if (!entry)
+		return false;
+	outPoints->assign(entry->points.begin(), entry->points.begin() + FindPoint(entry->points, offset) + 1);
+	entry->lastUsed = ++useCount;
+	return true;
+}
+
+void SavAccessCache::Remember(const header_s *header, const std::vector<SavAccessPoint> &points, const unsigned char *text)
+{
+	Entry *entry = FindEntry(header);
+	if (entry)
+	{
+		entry->lastUsed = ++useCount;
+		return;
+	}
+
+	Entry *slot = &entries[0];
+	for (Entry &other : entries)
+	{
+		if (other.lastUsed < slot->lastUsed)
+			slot = &other;
+	}
+
+	slot->lastUsed = 0;
+	try
+	{
+		slot->points = points;
+		slot->windows.resize(points.size() * EZ_DICTIONARYSIZE);
+	}
+	catch (const std::bad_alloc &)
+	{
+		//Only a missed shortcut; ranges of the save are inflated from the start instead
+		return;
+	}
+	slot->header = *header;
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		unsigned int windowSize = WindowSize(points[i]);
+		memcpy(&slot->windows[(i + 1) * EZ_DICTIONARYSIZE - windowSize], text + points[i].textOffset - windowSize, windowSize);
+	}
+	slot->lastUsed = ++useCount;
+}
+
+int InflateAccessible(	SavAccessCache &access,
+						ezstream *stream,
+						const header_s *header,
+						unsigned char *outText,
+						long *pnTextLen,
+						const unsigned char *compressedData,
+						long *pnCompressedLen)
+{
+	std::vector<SavAccessPoint> points;
+	bool noted = true; //Until there is no memory for another point
+	long textDone = 0;
+	long compressedDone = 0;
+	int zcode = 0;
+
+	while (true)
+	{
+		long outLen = *pnTextLen - textDone;
+		long inLen = *pnCompressedLen - compressedDone;
+		int bits = -1;
+		zcode = ezinflateblock(stream, outText + textDone, &outLen, compressedData + compressedDone, &inLen, &bits);
+		textDone += outLen;
+		compressedDone += inLen;
+		if (zcode != 0)
+			break;
+
+		//The first boundary comes right after the zlib header, so every offset has a point before it
+		if (noted && bits >= 0 && (points.empty() || (unsigned long)textDone - points.back().textOffset >= SAVACCESS_SPAN))
+		{
+			SavAccessPoint point = { (unsigned int)textDone, (unsigned int)compressedDone, bits, ezinflateadler(stream) };
+			try
+			{
+				points.push_back(point);
+			}
+			catch (const std::bad_alloc &)
+			{
+				noted = false;
+			}
+		}
+	}
+
+	*pnTextLen = textDone;
+	*pnCompressedLen = compressedDone;
+	if (noted && zcode == EZ_STREAM_END && (unsigned long)textDone == header->realSize && !points.empty())
+		access.Remember(header, points, outText);
+	return zcode;
+}
+
+int SavAccessCache::InflateRange(	SavStreamCache &streams,
+									SavArena &arena,
+									const header_s *header,
+									const unsigned char *compressedData,
+									unsigned int offset,
+									unsigned int size,
+									unsigned char *outText)
+{
+	unsigned char *discard = (unsigned char *)arena.Allocate(SAVACCESS_WINDOWSIZE);
+	if (!discard)
+		return ERR_MEMORY;
+
+	Entry *entry = FindEntry(header);
+	if (!entry)
+		return ERR_NOTCACHED;
+
+	size_t i = FindPoint(entry->points, offset);
+	const SavAccessPoint &point = entry->points[i];
+	const unsigned char *window = &entry->windows[i * EZ_DICTIONARYSIZE];
+	entry->lastUsed = ++useCount;
+
+	ezstream *stream = streams.AcquireRawInflate();
+	if (!stream)
+		return ERR_MEMORY;
+
+	//A block that starts mid-byte gets the rest of that byte first
+	int zcode = 0;
+	if (point.bits > 0)
+		zcode = ezinflateprime(stream, point.bits, compressedData[point.compressedOffset - 1] >> (8 - point.bits));
+	unsigned int windowSize = WindowSize(point);
+	if (zcode == 0 && windowSize > 0)
+		zcode = ezinflatedictionary(stream, window + EZ_DICTIONARYSIZE - windowSize, (long)windowSize);
+
+	const unsigned char *input = compressedData + point.compressedOffset;
+	unsigned int inputLeft = header->compressedSize - point.compressedOffset;
+	unsigned int skip = offset - point.textOffset;
+	unsigned int done = 0;
+	while (zcode == 0 && (skip > 0 || done < size))
+	{
+		//Text before offset goes to the discard window, the rest straight to outText
+		long inLen = (long)inputLeft;
+		long outLen = skip > 0 ? (long)(skip < SAVACCESS_WINDOWSIZE ? skip : SAVACCESS_WINDOWSIZE) : (long)(size - done);
+		zcode = ezinflatestream(stream, skip > 0 ? discard : outText + done, &outLen, input, &inLen);
+		input += inLen;
+		inputLeft -= (unsigned int)inLen;
+		if (skip > 0)
+			skip -= (unsigned int)outLen;
+		else
+			done += (unsigned int)outLen;
+	}
+	streams.ReleaseRawInflate(stream);
+
+	if (skip == 0 && done == size)
+		return 0;
+	//All remaining input was offered with room to spare, so a buffer error or the end means the payload is short
+	return zcode < 0 && zcode != EZ_BUF_ERROR ? zcode : ERR_DATA;
+}
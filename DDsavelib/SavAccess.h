@@ -0,0 +1,89 @@
+#pragma once
+
+#include "SavFormat.h"
+
+#include <vector>
+
+class SavArena;
+class SavStreamCache;
+struct ezstream;
+
+// Access points into a save's payload, so part of its text can be inflated without everything before it,
+// the way zlib's zran example does. A point is a deflate block boundary about every SAVACCESS_SPAN bytes of
+// text: where it falls in the payload, down to the bit, and the 32 KB of text before it that the blocks after
+// it can copy from. A SavAccessCache holds them for the last few saves a SavContext or SavDocument unpacked
+// or wrote; plain unpacks note none. Saves are told apart by their header, as in SavPackedCache.
+
+// Text between access points, the most that is inflated and thrown away to reach a range
+#define SAVACCESS_SPAN (1024 * 1024)
+
+// How many saves' points a cache remembers; the least recently used is forgotten first
+#define SAVACCESS_CACHESIZE 4
+
+struct SavAccessPoint
+{
+	unsigned int textOffset;
+	unsigned int compressedOffset; //First payload byte not consumed at the boundary
+	int bits; //Bits of the byte before compressedOffset that belong to the next block
+	unsigned long adler; //Adler-32 of the text before textOffset
+};
+
+// Like its owner, a cache is used by one call at a time
+class SavAccessCache
+{
+public:
+	SavAccessCache() : useCount(0) {}
+
+	// Whether the access points of the save with this header are remembered
+	bool Has(const header_s *header);
+
+	// Copies the save's access points at or before offset into outPoints, the closest one last.
+	// Returns false if its points aren't remembered.
+	bool Copy(const header_s *header, unsigned int offset, std::vector<SavAccessPoint> *outPoints);
+
+	// Remembers points worked out while inflating or compressing the save, in place of the least recently used
+	// save's. points must be in text order, starting with one right after the zlib header, and text is the whole
+	// text. Out of memory, they just aren't remembered.
+	void Remember(const header_s *header, const std::vector<SavAccessPoint> &points, const unsigned char *text);
+
+	// Inflates size bytes of the save's text, from offset on, into outText, entering the payload at the
+	// closest access point before offset. Returns 0, ERR_NOTCACHED if the save's points aren't remembered,
+	// ERR_DATA if the payload ends first, ERR_MEMORY, or a zlib error.
+	int InflateRange(	SavStreamCache &streams,
+						SavArena &arena,
+						const header_s *header,
+						const unsigned char *compressedData,
+						unsigned int offset,
+						unsigned int size,
+						unsigned char *outText);
+
+private:
+	struct Entry
+	{
+		Entry() : lastUsed(0) {}
+
+		header_s header;
+		unsigned long long lastUsed; //0 while the entry is empty
+		std::vector<SavAccessPoint> points; //In text order; the first is right after the zlib header
+		std::vector<unsigned char> windows; //EZ_DICTIONARYSIZE bytes per point, ending with the text before it
+	};
+
+	SavAccessCache(const SavAccessCache &);
+	SavAccessCache &operator=(const SavAccessCache &);
+
+	Entry *FindEntry(const header_s *header);
+
+	Entry entries[SAVACCESS_CACHESIZE];
+	unsigned long long useCount;
+};
+
+// Inflates a whole payload like one call to ezinflatestream on stream, a freshly reset zlib inflate stream,
+// stopping at each deflate block on the way to note access points. They are remembered in access if the text
+// comes out at exactly realSize.
+int InflateAccessible(	SavAccessCache &access,
+						ezstream *stream,
+						const header_s *header,
+						unsigned char *outText,
+						long *pnTextLen,
+						const unsigned char *compressedData,
+						long *pnCompressedLen);
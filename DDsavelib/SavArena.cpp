@@ -0,0 +1,129 @@
+// SavArena.cpp : Bump allocator reset once per save.
+//
+
+#include "SavArena.h"
+
+#include <stdlib.h>
+#include <new>
+
+//Every block starts on this boundary, as malloc's would
+#define SAVARENA_ALIGNMENT 16
+
+SavArena::~SavArena()
+{
+	for (const Chunk &chunk : chunks)
+		free(chunk.data);
+}
+
+namespace
+{
+	size_t Align(size_t size)
+	{
+		return (size + SAVARENA_ALIGNMENT - 1) & ~(size_t)(SAVARENA_ALIGNMENT - 1);
+	}
+}
+
+void *SavArena::Allocate(size_t size)
+{
+	size = Align(size);
+	std::lock_guard<std::mutex> guard(lock);
+
+	//Chunks kept from earlier saves are used in order before asking the heap for more
+	while (current < chunks.size())
+	{
+		Chunk &chunk = chunks[current];
+		if (chunk.size - used >= size)
+		{
+			void *block = chunk.data + used;
+			used += size;
+			return block;
+		}
+		++current;
+		used = 0;
+	}
+
+	Chunk chunk;
+	chunk.size = size > SAVARENA_CHUNKSIZE ? size : SAVARENA_CHUNKSIZE;
+	chunk.data = (unsigned char *)malloc(chunk.size);
+	if (!chunk.data)
+		return 0;
+	try
+	{
+		chunks.push_back(chunk);
+	}
+	catch (const std::bad_alloc &)
+	{
+		//Allocate is reached from zlib's zalloc, which must not throw
+		free(chunk.data);
+		return 0;
+	}
+	current = chunks.size() - 1;
+	used = size;
+	return chunk.data;
+}
+
+void SavArena::Trim(void *block, size_t size, size_t newSize)
+{
+	size = Align(size);
+	newSize = Align(newSize);
+	std::lock_guard<std::mutex> guard(lock);
+	if (current < chunks.size() && (unsigned char *)block + size == chunks[current].data + used)
+		used -= size - newSize;
+}
+
+void SavArena::Reset()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	current = 0;
+	used = 0;
+	freed = 0;
+}
+
+void *SavArena::Reuse(size_t size)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	for (FreeBlock **link = &freed; *link; link = &(*link)->next)
+	{
+		FreeBlock *block = *link;
+		if (block->size == size)
+		{
+			*link = block->next;
+			return block;
+		}
+	}
+	return 0;
+}
+
+void SavArena::Recycle(void *block, size_t size)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	FreeBlock *free = (FreeBlock *)block;
+	free->next = freed;
+	free->size = size;
+	freed = free;
+}
+
+void *SavArena::ZAlloc(void *opaque, unsigned int items, unsigned int size)
+{
+	SavArena *arena = (SavArena *)opaque;
+
+	//Each block is preceded by its size, so ZFree knows which requests it can be handed back for
+	size_t blockSize = Align((size_t)items * size);
+	if (blockSize < sizeof(FreeBlock))
+		blockSize = Align(sizeof(FreeBlock));
+	unsigned char *block = (unsigned char *)arena->Reuse(blockSize);
+	if (block)
+		return block;
+
+	block = (unsigned char *)arena->Allocate(SAVARENA_ALIGNMENT + blockSize);
+	if (!block)
+		return 0;
+	*(size_t *)block = blockSize;
+	return block + SAVARENA_ALIGNMENT;
+}
+
+void SavArena::ZFree(void *opaque, void *address)
+{
+	unsigned char *block = (unsigned char *)address;
+	((SavArena *)opaque)->Recycle(block, *(size_t *)(block - SAVARENA_ALIGNMENT));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <mutex>
+#include <stddef.h>
+#include <vector>
+
+// Smallest chunk an arena asks the heap for, room for a deflate stream's tables in one
+#define SAVARENA_CHUNKSIZE (512 * 1024)
+
+// Bump allocator for memory that only lives as long as one save. Freeing a block does nothing;
+// Reset gives everything back at once and keeps the chunks, so once an arena has seen a save,
+// the next one like it makes no heap calls at all. Blocks may be allocated from several threads.
+// Blocks zlib frees through ZFree are the exception: they are kept and handed out again by ZAlloc
+// for the same size, so streams closed and reopened on a long-lived arena don't make it grow.
+class SavArena
+{
+public:
+	SavArena() : current(0), used(0), freed(0) {}
+	~SavArena();
+
+	// size bytes aligned for any type, or null if the heap is out of memory
+	void *Allocate(size_t size);
+	// Gives back the end of block, allocated with size bytes, past newSize, if nothing was allocated after it
+	void Trim(void *block, size_t size, size_t newSize);
+	// Frees every block allocated so far, in constant time
+	void Reset();
+
+	// zalloc and zfree for zlib streams whose opaque is a SavArena
+	static void *ZAlloc(void *opaque, unsigned int items, unsigned int size);
+	static void ZFree(void *opaque, void *address);
+
+private:
+	struct Chunk
+	{
+		unsigned char *data;
+		size_t size;
+	};
+
+	// A block zlib freed, linked through its own memory until ZAlloc takes it again
+	struct FreeBlock
+	{
+		FreeBlock *next;
+		size_t size;
+	};
+
+	void *Reuse(size_t size);
+	void Recycle(void *block, size_t size);
+
+	SavArena(const SavArena &);
+	SavArena &operator=(const SavArena &);
+
+	std::mutex lock;
+	std::vector<Chunk> chunks;
+	size_t current; //Chunk blocks are being taken from
+	size_t used; //Bytes of it already handed out
+	FreeBlock *freed; //Blocks from ZFree, cleared by Reset
+};
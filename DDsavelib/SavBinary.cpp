@@ -0,0 +1,861 @@
+// SavBinary.cpp : Compact typed tree of unpacked save text.
+//
+
+#include "SavBinary.h"
+#include "SavFormat.h"
+#include "SavXml.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	enum Kind
+	{
+		KindClass,
+		KindClassref,
+		KindArray,
+		KindU8,
+		KindS8,
+		KindU16,
+		KindS16,
+		KindU32,
+		KindS32,
+		KindU64,
+		KindF32,
+		KindBool,
+		KindString,
+		KindVector3,
+		KindTime,
+		KindRaw, //Self-closing element kept verbatim
+		KindRawContainer //Element with children whose start tag is kept verbatim
+	};
+
+	//Tag of each kind up to KindTime
+	const char *const KindTags[] = {
+		"class", "classref", "array", "u8", "s8", "u16", "s16", "u32", "s32", "u64", "f32", "bool", "string", "vector3", "time"
+	};
+	const unsigned int TaggedKindCount = sizeof(KindTags) / sizeof(KindTags[0]);
+
+	const char *const TimeFields[] = { "year", "month", "day", "hour", "minute", "second" };
+	const char *const Vector3Fields[] = { "x", "y", "z" };
+
+	const unsigned int NoName = 0xFFFFFF;
+
+	const unsigned char FlagEmpty = 1; //Written as a self-closing tag
+	const unsigned char FlagPacked = 2; //Items are a range of their kind's column instead of child nodes
+
+	//Longest tag checked against its written form; longer ones are kept verbatim
+	const unsigned int ScratchSize = 1024;
+
+	unsigned int KindFromTag(const char *tag, unsigned int size)
+	{
+		for (unsigned int kind = 0; kind < TaggedKindCount; ++kind)
+		{
+			if (strlen(KindTags[kind]) == size && memcmp(KindTags[kind], tag, size) == 0)
+				return kind;
+		}
+		return KindRaw;
+	}
+
+	//FNV-1a
+	size_t HashName(const char *data, unsigned int size)
+	{
+		unsigned int hash = 2166136261u;
+		for (unsigned int i = 0; i < size; ++i)
+			hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+		return hash;
+	}
+
+	bool IsScalarKind(unsigned int kind)
+	{
+		return kind >= KindU8 && kind <= KindTime;
+	}
+
+	bool ParseUnsigned(const SavXmlSpan &span, unsigned long long max, unsigned long long *outValue)
+	{
+		if (span.size == 0 || span.size > 20)
+			return false;
+		unsigned long long value = 0;
+		for (unsigned int i = 0; i < span.size; ++i)
+		{
+			char c = span.data[i];
+			if (c < '0' || c > '9' || value > (max - (c - '0')) / 10)
+				return false;
+			value = value * 10 + (c - '0');
+		}
+		*outValue = value;
+		return true;
+	}
+
+	bool ParseSigned(const SavXmlSpan &span, long long min, long long max, long long *outValue)
+	{
+		bool negative = span.size > 0 && span.data[0] == '-';
+		SavXmlSpan digits = span;
+		if (negative)
+		{
+			++digits.data;
+			--digits.size;
+		}
+		unsigned long long magnitude;
+		if (!ParseUnsigned(digits, negative ? 0ULL - (unsigned long long)min : (unsigned long long)max, &magnitude))
+			return false;
+		*outValue = negative ? (long long)(0ULL - magnitude) : (long long)magnitude;
+		return true;
+	}
+
+	bool ParseFloat(const SavXmlSpan &span, float *outValue)
+	{
+		char buffer[64];
+		if (span.size == 0 || span.size >= sizeof(buffer))
+			return false;
+		memcpy(buffer, span.data, span.size);
+		buffer[span.size] = 0;
+		char *end;
+		*outValue = strtof(buffer, &end);
+		return end == buffer + span.size;
+	}
+
+	//Finds one attribute among the ones SavXmlReader doesn't pick out itself
+	bool FindAttribute(const SavXmlSpan &attributes, const char *name, SavXmlSpan *outValue)
+	{
+		size_t nameSize = strlen(name);
+		const char *p = attributes.data;
+		const char *end = attributes.data + attributes.size;
+		while (p < end)
+		{
+			while (p < end && *p == ' ')
+				++p;
+			const char *equals = (const char *)memchr(p, '=', end - p);
+			if (!equals || equals + 1 >= end)
+				return false;
+			char quote = equals[1];
+			const char *valueStart = equals + 2;
+			const char *valueEnd = (const char *)memchr(valueStart, quote, end - valueStart);
+			if (!valueEnd)
+				return false;
+			if ((size_t)(equals - p) == nameSize && memcmp(p, name, nameSize) == 0)
+			{
+				outValue->data = valueStart;
+				outValue->size = (unsigned int)(valueEnd - valueStart);
+				return true;
+			}
+			p = valueEnd + 1;
+		}
+		return false;
+	}
+}
+
+// Writes into a fixed buffer, counting what doesn't fit so the caller learns the size it needed
+class SavBinary::TextWriter
+{
+public:
+	TextWriter(char *out, unsigned int capacity) : out(out), capacity(capacity), size(0) {}
+
+	void Put(const char *data, unsigned int count)
+	{
+		if (size <= capacity && count <= capacity - size)
+			memcpy(out + size, data, count);
+		size += count;
+	}
+
+	void Put(const char *str) { Put(str, (unsigned int)strlen(str)); }
+	void Put(char c) { Put(&c, 1); }
+
+	void PutUnsigned(unsigned long long value)
+	{
+		char digits[20];
+		char *p = digits + sizeof(digits);
+		do
+		{
+			*--p = (char)('0' + value % 10);
+			value /= 10;
+		} while (value);
+		Put(p, (unsigned int)(digits + sizeof(digits) - p));
+	}
+
+	void PutSigned(long long value)
+	{
+		if (value < 0)
+		{
+			Put('-');
+			PutUnsigned(0ULL - (unsigned long long)value);
+		}
+		else
+		{
+			PutUnsigned((unsigned long long)value);
+		}
+	}
+
+	void PutFloat(float value)
+	{
+		//Saves write f32 values the way printf's %f does
+		char digits[64];
+		int count = snprintf(digits, sizeof(digits), "%f", (double)value);
+		if (count > 0)
+			Put(digits, (unsigned int)count < sizeof(digits) ? (unsigned int)count : (unsigned int)sizeof(digits) - 1);
+	}
+
+	unsigned int Size() const { return size; }
+
+private:
+	char *out;
+	unsigned int capacity;
+	unsigned int size;
+};
+
+unsigned int SavBinary::Intern(const char *data, unsigned int size)
+{
+	//Open addressing over the names themselves, kept at most half full
+	if (nameIds.size() < (names.size() + 1) * 2)
+	{
+		std::vector<unsigned int> grown(nameIds.empty() ? 1024 : nameIds.size() * 2, NoName);
+		for (unsigned int id = 0; id < names.size(); ++id)
+		{
+			size_t slot = HashName(&pool[names[id].offset], names[id].size) & (grown.size() - 1);
+			while (grown[slot] != NoName)
+				slot = (slot + 1) & (grown.size() - 1);
+			grown[slot] = id;
+		}
+		nameIds.swap(grown);
+	}
+
+	size_t slot = HashName(data, size) & (nameIds.size() - 1);
+	while (nameIds[slot] != NoName)
+	{
+		const PoolSpan &name = names[nameIds[slot]];
+		if (name.size == size && memcmp(&pool[name.offset], data, size) == 0)
+			return nameIds[slot];
+		slot = (slot + 1) & (nameIds.size() - 1);
+	}
+
+	unsigned int id = (unsigned int)names.size();
+	names.push_back(AddToPool(data, size));
+	nameIds[slot] = id;
+	return id;
+}
+
+SavBinary::PoolSpan SavBinary::AddToPool(const char *data, unsigned int size)
+{
+	PoolSpan span = { (unsigned int)pool.size(), size };
+	pool.insert(pool.end(), data, data + size);
+	return span;
+}
+
+bool SavBinary::IsContainer(unsigned int node) const
+{
+	unsigned int kind = nodes[node].kind;
+	return kind == KindClass || kind == KindClassref || kind == KindArray || kind == KindRawContainer;
+}
+
+int SavBinary::Build(const char *text, unsigned int size)
+{
+	*this = SavBinary();
+	xmlSize = size;
+
+	std::vector<unsigned int> open;
+	unsigned int cursor = 0;
+	bool started = false;
+
+	SavXmlReader reader(text, size);
+	SavXmlEvent e;
+	while (true)
+	{
+		int errcode = reader.Next(&e);
+		if (errcode)
+			return errcode;
+		if (e.kind == SAVXML_EOF)
+			break;
+		//The END of a self-closing element repeats its START
+		if (e.kind == SAVXML_END && e.isEmpty)
+			continue;
+
+		//Tags follow each other one per line; anything else can't be written back
+		if (!started)
+		{
+			prolog = AddToPool(text, e.offset);
+			started = true;
+		}
+		else if (e.offset != cursor + 1 || text[cursor] != '\n')
+		{
+			return ERR_FORMAT;
+		}
+		cursor = e.offset + e.size;
+
+		if (e.kind == SAVXML_START)
+		{
+			unsigned int node;
+			AddStart(e, text, &node);
+			if (!e.isEmpty)
+				open.push_back(node);
+		}
+		else
+		{
+			unsigned int node = open.back();
+			open.pop_back();
+			containers[nodes[node].value].end = (unsigned int)nodes.size();
+
+			char scratch[ScratchSize];
+			TextWriter writer(scratch, ScratchSize);
+			WriteEnd(writer, node);
+			if (writer.Size() != e.size || e.size > ScratchSize || memcmp(scratch, text + e.offset, e.size) != 0)
+				return ERR_FORMAT;
+
+			if (nodes[node].kind == KindArray)
+				PackArray(node);
+		}
+	}
+	if (!started)
+		return ERR_FORMAT;
+	epilog = AddToPool(text + cursor, size - cursor);
+
+	//Names are only looked up while building
+	std::vector<unsigned int>().swap(nameIds);
+	pool.shrink_to_fit();
+	names.shrink_to_fit();
+	nodes.shrink_to_fit();
+	containers.shrink_to_fit();
+	u8s.shrink_to_fit();
+	s8s.shrink_to_fit();
+	u16s.shrink_to_fit();
+	s16s.shrink_to_fit();
+	u32s.shrink_to_fit();
+	s32s.shrink_to_fit();
+	u64s.shrink_to_fit();
+	f32s.shrink_to_fit();
+	bools.shrink_to_fit();
+	strings.shrink_to_fit();
+	vector3s.shrink_to_fit();
+	times.shrink_to_fit();
+	raws.shrink_to_fit();
+	return 0;
+}
+
+void SavBinary::AddStart(const SavXmlEvent &e, const char *text, unsigned int *outNode)
+{
+	Node node;
+	node.kind = KindFromTag(e.tag.data, e.tag.size);
+	node.name = e.name.data ? Intern(e.name.data, e.name.size) : NoName;
+	node.value = 0;
+
+	bool parsed = true;
+	unsigned long long u = 0;
+	long long s = 0;
+	float f = 0;
+	switch (node.kind)
+	{
+	case KindClass:
+	case KindClassref:
+	case KindArray:
+	{
+		Container container = {};
+		container.type = e.type.data ? Intern(e.type.data, e.type.size) : NoName;
+		container.count = e.count;
+		container.flags = e.isEmpty ? FlagEmpty : 0;
+		node.value = (unsigned int)containers.size();
+		containers.push_back(container);
+		break;
+	}
+	case KindU8:
+		if ((parsed = ParseUnsigned(e.value, 0xFF, &u)) != false)
+		{
+			node.value = (unsigned int)u8s.size();
+			u8s.push_back((unsigned char)u);
+		}
+		break;
+	case KindS8:
+		if ((parsed = ParseSigned(e.value, -0x80, 0x7F, &s)) != false)
+		{
+			node.value = (unsigned int)s8s.size();
+			s8s.push_back((signed char)s);
+		}
+		break;
+	case KindU16:
+		if ((parsed = ParseUnsigned(e.value, 0xFFFF, &u)) != false)
+		{
+			node.value = (unsigned int)u16s.size();
+			u16s.push_back((unsigned short)u);
+		}
+		break;
+	case KindS16:
+		if ((parsed = ParseSigned(e.value, -0x8000, 0x7FFF, &s)) != false)
+		{
+			node.value = (unsigned int)s16s.size();
+			s16s.push_back((short)s);
+		}
+		break;
+	case KindU32:
+		if ((parsed = ParseUnsigned(e.value, 0xFFFFFFFF, &u)) != false)
+		{
+			node.value = (unsigned int)u32s.size();
+			u32s.push_back((unsigned int)u);
+		}
+		break;
+	case KindS32:
+		if ((parsed = ParseSigned(e.value, -0x7FFFFFFFLL - 1, 0x7FFFFFFF, &s)) != false)
+		{
+			node.value = (unsigned int)s32s.size();
+			s32s.push_back((int)s);
+		}
+		break;
+	case KindU64:
+		if ((parsed = ParseUnsigned(e.value, 0xFFFFFFFFFFFFFFFFULL, &u)) != false)
+		{
+			node.value = (unsigned int)u64s.size();
+			u64s.push_back(u);
+		}
+		break;
+	case KindF32:
+		if ((parsed = ParseFloat(e.value, &f)) != false)
+		{
+			node.value = (unsigned int)f32s.size();
+			f32s.push_back(f);
+		}
+		break;
+	case KindBool:
+		parsed = SpanEquals(e.value, "true") || SpanEquals(e.value, "false");
+		if (parsed)
+		{
+			node.value = (unsigned int)bools.size();
+			bools.push_back(e.value.size == 4);
+		}
+		break;
+	case KindString:
+		parsed = e.value.data != 0;
+		if (parsed)
+		{
+			node.value = (unsigned int)strings.size();
+			strings.push_back(AddToPool(e.value.data, e.value.size));
+		}
+		break;
+	case KindVector3:
+	{
+		float xyz[3];
+		SavXmlSpan field;
+		for (int i = 0; i < 3 && parsed; ++i)
+			parsed = FindAttribute(e.attributes, Vector3Fields[i], &field) && ParseFloat(field, &xyz[i]);
+		if (parsed)
+		{
+			node.value = (unsigned int)(vector3s.size() / 3);
+			vector3s.insert(vector3s.end(), xyz, xyz + 3);
+		}
+		break;
+	}
+	case KindTime:
+	{
+		int fields[6];
+		SavXmlSpan field;
+		for (int i = 0; i < 6 && parsed; ++i)
+		{
+			parsed = FindAttribute(e.attributes, TimeFields[i], &field) && ParseSigned(field, -0x7FFFFFFFLL - 1, 0x7FFFFFFF, &s);
+			fields[i] = (int)s;
+		}
+		if (parsed)
+		{
+			node.value = (unsigned int)(times.size() / 6);
+			times.insert(times.end(), fields, fields + 6);
+		}
+		break;
+	}
+	default:
+		parsed = false;
+		break;
+	}
+
+	*outNode = (unsigned int)nodes.size();
+	nodes.push_back(node);
+
+	//Keep the element verbatim unless writing it back gives exactly the same tag
+	bool matches = false;
+	if (parsed && (e.isEmpty || IsContainer(*outNode)))
+	{
+		char scratch[ScratchSize];
+		TextWriter writer(scratch, ScratchSize);
+		WriteStart(writer, *outNode);
+		matches = writer.Size() == e.size && e.size <= ScratchSize && memcmp(scratch, text + e.offset, e.size) == 0;
+	}
+	if (!matches)
+	{
+		if (parsed)
+			PopValue(node.kind);
+		MakeVerbatim(*outNode, e, text);
+	}
+}
+
+void SavBinary::PopValue(unsigned int kind)
+{
+	switch (kind)
+	{
+	case KindClass:
+	case KindClassref:
+	case KindArray:
+		containers.pop_back();
+		break;
+	case KindU8: u8s.pop_back(); break;
+	case KindS8: s8s.pop_back(); break;
+	case KindU16: u16s.pop_back(); break;
+	case KindS16: s16s.pop_back(); break;
+	case KindU32: u32s.pop_back(); break;
+	case KindS32: s32s.pop_back(); break;
+	case KindU64: u64s.pop_back(); break;
+	case KindF32: f32s.pop_back(); break;
+	case KindBool: bools.pop_back(); break;
+	case KindString: strings.pop_back(); break;
+	case KindVector3: vector3s.resize(vector3s.size() - 3); break;
+	case KindTime: times.resize(times.size() - 6); break;
+	}
+}
+
+void SavBinary::MakeVerbatim(unsigned int node, const SavXmlEvent &e, const char *text)
+{
+	unsigned int raw = (unsigned int)raws.size();
+	raws.push_back(AddToPool(text + e.offset, e.size));
+
+	if (e.isEmpty)
+	{
+		nodes[node].kind = KindRaw;
+		nodes[node].value = raw;
+	}
+	else
+	{
+		//The tag is kept for the end tag, in count since a verbatim container has no count of its own
+		Container container = {};
+		container.type = raw;
+		container.count = Intern(e.tag.data, e.tag.size);
+		nodes[node].kind = KindRawContainer;
+		nodes[node].value = (unsigned int)containers.size();
+		containers.push_back(container);
+	}
+}
+
+void SavBinary::PackArray(unsigned int node)
+{
+	Container &array = containers[nodes[node].value];
+	unsigned int itemKind = KindRaw;
+	if (array.type != NoName)
+		itemKind = KindFromTag(&pool[names[array.type].offset], names[array.type].size);
+
+	unsigned int first = node + 1;
+	unsigned int itemCount = (unsigned int)nodes.size() - first;
+	if (!IsScalarKind(itemKind) || itemCount == 0)
+		return;
+
+	//Only arrays whose every child is an unnamed item of the array's type, in column order
+	for (unsigned int i = 0; i < itemCount; ++i)
+	{
+		const Node &item = nodes[first + i];
+		if (item.kind != itemKind || item.name != NoName || item.value != nodes[first].value + i)
+			return;
+	}
+
+	array.first = nodes[first].value;
+	array.itemCount = itemCount;
+	array.itemKind = (unsigned char)itemKind;
+	array.flags |= FlagPacked;
+	array.end = first;
+	nodes.resize(first);
+}
+
+void SavBinary::WritePool(TextWriter &writer, const PoolSpan &span) const
+{
+	if (span.size > 0)
+		writer.Put(&pool[span.offset], span.size);
+}
+
+void SavBinary::WriteValue(TextWriter &writer, unsigned int kind, unsigned int index) const
+{
+	switch (kind)
+	{
+	case KindU8: writer.PutUnsigned(u8s[index]); break;
+	case KindS8: writer.PutSigned(s8s[index]); break;
+	case KindU16: writer.PutUnsigned(u16s[index]); break;
+	case KindS16: writer.PutSigned(s16s[index]); break;
+	case KindU32: writer.PutUnsigned(u32s[index]); break;
+	case KindS32: writer.PutSigned(s32s[index]); break;
+	case KindU64: writer.PutUnsigned(u64s[index]); break;
+	case KindF32: writer.PutFloat(f32s[index]); break;
+	case KindBool: writer.Put(bools[index] ? "true" : "false"); break;
+	case KindString: WritePool(writer, strings[index]); break;
+	}
+}
+
+void SavBinary::WriteName(TextWriter &writer, unsigned int name) const
+{
+	if (name != NoName)
+	{
+		writer.Put(" name=\"");
+		WritePool(writer, names[name]);
+		writer.Put('"');
+	}
+}
+
+void SavBinary::WriteScalar(TextWriter &writer, unsigned int kind, unsigned int name, unsigned int index) const
+{
+	writer.Put('<');
+	writer.Put(KindTags[kind]);
+	WriteName(writer, name);
+
+	switch (kind)
+	{
+	case KindVector3:
+		for (int i = 0; i < 3; ++i)
+		{
+			writer.Put(' ');
+			writer.Put(Vector3Fields[i]);
+			writer.Put("=\"");
+			writer.PutFloat(vector3s[index * 3 + i]);
+			writer.Put('"');
+		}
+		break;
+	case KindTime:
+		for (int i = 0; i < 6; ++i)
+		{
+			writer.Put(' ');
+			writer.Put(TimeFields[i]);
+			writer.Put("=\"");
+			writer.PutSigned(times[index * 6 + i]);
+			writer.Put('"');
+		}
+		break;
+	default:
+		writer.Put(" value=\"");
+		WriteValue(writer, kind, index);
+		writer.Put('"');
+		break;
+	}
+	writer.Put("/>");
+}
+
+void SavBinary::WriteStart(TextWriter &writer, unsigned int node) const
+{
+	const Node &n = nodes[node];
+	if (n.kind == KindRaw)
+	{
+		WritePool(writer, raws[n.value]);
+		return;
+	}
+	if (n.kind == KindRawContainer)
+	{
+		WritePool(writer, raws[containers[n.value].type]);
+		return;
+	}
+	if (IsScalarKind(n.kind))
+	{
+		WriteScalar(writer, n.kind, n.name, n.value);
+		return;
+	}
+
+	const Container &container = containers[n.value];
+	writer.Put('<');
+	writer.Put(KindTags[n.kind]);
+	WriteName(writer, n.name);
+	if (container.type != NoName)
+	{
+		writer.Put(" type=\"");
+		WritePool(writer, names[container.type]);
+		writer.Put('"');
+	}
+	if (n.kind == KindArray)
+	{
+		writer.Put(" count=\"");
+		writer.PutUnsigned(container.count);
+		writer.Put('"');
+	}
+	writer.Put((container.flags & FlagEmpty) ? "/>" : ">");
+}
+
+void SavBinary::WriteEnd(TextWriter &writer, unsigned int node) const
+{
+	const Node &n = nodes[node];
+	writer.Put("</");
+	if (n.kind == KindRawContainer)
+		WritePool(writer, names[containers[n.value].count]);
+	else
+		writer.Put(KindTags[n.kind]);
+	writer.Put('>');
+}
+
+int SavBinary::ToXml(char *outText, unsigned int capacity, unsigned int *outSize) const
+{
+	TextWriter writer(outText, capacity);
+	WritePool(writer, prolog);
+
+	//Containers whose end tags are still to come, innermost last
+	std::vector<unsigned int> open;
+
+	for (unsigned int node = 0; node < nodes.size(); ++node)
+	{
+		while (!open.empty() && containers[nodes[open.back()].value].end == node)
+		{
+			writer.Put('\n');
+			WriteEnd(writer, open.back());
+			open.pop_back();
+		}
+		if (node > 0)
+			writer.Put('\n');
+		WriteStart(writer, node);
+
+		if (!IsContainer(node))
+			continue;
+
+		const Container &container = containers[nodes[node].value];
+		if (container.flags & FlagPacked)
+		{
+			for (unsigned int i = 0; i < container.itemCount; ++i)
+			{
+				writer.Put('\n');
+				WriteScalar(writer, container.itemKind, NoName, container.first + i);
+			}
+		}
+		if (!(container.flags & FlagEmpty))
+			open.push_back(node);
+	}
+	while (!open.empty())
+	{
+		writer.Put('\n');
+		WriteEnd(writer, open.back());
+		open.pop_back();
+	}
+	WritePool(writer, epilog);
+
+	*outSize = writer.Size();
+	return writer.Size() > capacity ? ERR_BUFFERSIZE : 0;
+}
+
+int SavBinary::Find(const char *path, SavBinaryRef *outRef) const
+{
+	if (nodes.empty())
+		return ERR_PATH;
+
+	unsigned int node = 0;
+	const char *segment = path;
+	while (true)
+	{
+		const char *segmentEnd = strchr(segment, '/');
+		unsigned int segmentSize = segmentEnd ? (unsigned int)(segmentEnd - segment) : (unsigned int)strlen(segment);
+		if (!IsContainer(node))
+			return ERR_PATH;
+
+		//#N picks the Nth child; anything else is a name attribute
+		bool byIndex = segmentSize > 1 && segment[0] == '#';
+		unsigned long long index = 0;
+		if (byIndex)
+		{
+			SavXmlSpan digits = { segment + 1, segmentSize - 1 };
+			if (!ParseUnsigned(digits, 0xFFFFFFFF, &index))
+				byIndex = false;
+		}
+
+		const Container &container = containers[nodes[node].value];
+		if (container.flags & FlagPacked)
+		{
+			if (!byIndex || index >= container.itemCount || segmentEnd)
+				return ERR_PATH;
+			outRef->node = node;
+			outRef->item = (unsigned int)index;
+			return 0;
+		}
+
+		unsigned int found = 0xFFFFFFFF;
+		unsigned int childIndex = 0;
+		for (unsigned int child = node + 1; child < container.end; ++childIndex)
+		{
+			const Node &candidate = nodes[child];
+			if (byIndex ? childIndex == index :
+				(candidate.name != NoName &&
+				names[candidate.name].size == segmentSize &&
+				memcmp(&pool[names[candidate.name].offset], segment, segmentSize) == 0))
+			{
+				found = child;
+				break;
+			}
+			child = IsContainer(child) ? containers[candidate.value].end : child + 1;
+		}
+		if (found == 0xFFFFFFFF)
+			return ERR_PATH;
+
+		node = found;
+		if (!segmentEnd)
+			break;
+		segment = segmentEnd + 1;
+	}
+
+	outRef->node = node;
+	outRef->item = SAVBINARY_NOITEM;
+	return 0;
+}
+
+int SavBinary::GetInt(const SavBinaryRef &ref, long long *outValue) const
+{
+	unsigned int kind, index;
+	if (!Locate(ref, &kind, &index))
+		return ERR_PATH;
+
+	switch (kind)
+	{
+	case KindU8: *outValue = u8s[index]; return 0;
+	case KindS8: *outValue = s8s[index]; return 0;
+	case KindU16: *outValue = u16s[index]; return 0;
+	case KindS16: *outValue = s16s[index]; return 0;
+	case KindU32: *outValue = u32s[index]; return 0;
+	case KindS32: *outValue = s32s[index]; return 0;
+	case KindU64: *outValue = (long long)u64s[index]; return 0;
+	case KindBool: *outValue = bools[index]; return 0;
+	default: return ERR_FORMAT;
+	}
+}
+
+int SavBinary::GetFloat(const SavBinaryRef &ref, float *outValue) const
+{
+	unsigned int kind, index;
+	if (!Locate(ref, &kind, &index))
+		return ERR_PATH;
+	if (kind != KindF32)
+		return ERR_FORMAT;
+	*outValue = f32s[index];
+	return 0;
+}
+
+bool SavBinary::Locate(const SavBinaryRef &ref, unsigned int *outKind, unsigned int *outIndex) const
+{
+	if (ref.node >= nodes.size())
+		return false;
+
+	if (ref.item == SAVBINARY_NOITEM)
+	{
+		*outKind = nodes[ref.node].kind;
+		*outIndex = nodes[ref.node].value;
+		return true;
+	}
+
+	if (!IsContainer(ref.node))
+		return false;
+	const Container &container = containers[nodes[ref.node].value];
+	if (!(container.flags & FlagPacked) || ref.item >= container.itemCount)
+		return false;
+	*outKind = container.itemKind;
+	*outIndex = container.first + ref.item;
+	return true;
+}
+
+size_t SavBinary::GetMemorySize() const
+{
+	return pool.capacity() +
+		names.capacity() * sizeof(PoolSpan) +
+		nodes.capacity() * sizeof(Node) +
+		containers.capacity() * sizeof(Container) +
+		u8s.capacity() +
+		s8s.capacity() +
+		u16s.capacity() * sizeof(unsigned short) +
+		s16s.capacity() * sizeof(short) +
+		u32s.capacity() * sizeof(unsigned int) +
+		s32s.capacity() * sizeof(int) +
+		u64s.capacity() * sizeof(unsigned long long) +
+		f32s.capacity() * sizeof(float) +
+		bools.capacity() +
+		strings.capacity() * sizeof(PoolSpan) +
+		vector3s.capacity() * sizeof(float) +
+		times.capacity() * sizeof(int) +
+		raws.capacity() * sizeof(PoolSpan);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "DDsavelib.h"
+
+#include <stddef.h>
+#include <vector>
+
+// Unpacked save text held as a compact tree. Element, attribute and type names are interned once;
+// scalar values are parsed into one column per type; arrays of unnamed scalars keep only a range of
+// their column. Every element is checked against how it would be written back, and elements that
+// don't match their type's usual layout are kept verbatim, so ToXml always gives back the exact text.
+struct SavBinary
+{
+	// Converts unpacked text. Returns 0, or ERR_FORMAT if the text isn't well formed or has anything
+	// but a single newline between two tags.
+	int Build(const char *text, unsigned int size);
+
+	unsigned int GetXmlSize() const { return xmlSize; }
+
+	// Writes the text Build was given. *outSize gets its length; if that's more than capacity,
+	// nothing past capacity is written and ERR_BUFFERSIZE is returned.
+	int ToXml(char *outText, unsigned int capacity, unsigned int *outSize) const;
+
+	// Finds a value by path, in the syntax SavPathMatcher uses. Returns ERR_PATH if there is none.
+	int Find(const char *path, SavBinaryRef *outRef) const;
+
+	// Reads an integer or bool value. Returns ERR_FORMAT if ref holds some other type.
+	int GetInt(const SavBinaryRef &ref, long long *outValue) const;
+	// Reads an f32 value. Returns ERR_FORMAT if ref holds some other type.
+	int GetFloat(const SavBinaryRef &ref, float *outValue) const;
+
+	// Bytes held by the tree, not counting the SavBinary itself
+	size_t GetMemorySize() const;
+
+private:
+	//Where a string sits in the pool
+	struct PoolSpan
+	{
+		unsigned int offset;
+		unsigned int size;
+	};
+
+	struct Node
+	{
+		unsigned int kind : 8;
+		unsigned int name : 24; //Interned name attribute
+		unsigned int value; //Index into the kind's column, or into containers
+	};
+
+	struct Container
+	{
+		unsigned int type; //Interned type attribute; for a verbatim container, its start tag in raws
+		unsigned int count; //Parsed count attribute of arrays; for a verbatim container, its interned tag
+		unsigned int end; //Index of the first node after this container's subtree
+		unsigned int first; //First column index of packed items
+		unsigned int itemCount; //Number of packed items
+		unsigned char itemKind; //Kind of packed items
+		unsigned char flags;
+	};
+
+	class TextWriter;
+
+	unsigned int Intern(const char *data, unsigned int size);
+	PoolSpan AddToPool(const char *data, unsigned int size);
+
+	bool IsContainer(unsigned int node) const;
+	void AddStart(const SavXmlEvent &e, const char *text, unsigned int *outNode);
+	void MakeVerbatim(unsigned int node, const SavXmlEvent &e, const char *text);
+	void PopValue(unsigned int kind);
+	void PackArray(unsigned int node);
+	bool Locate(const SavBinaryRef &ref, unsigned int *outKind, unsigned int *outIndex) const;
+
+	void WriteStart(TextWriter &writer, unsigned int node) const;
+	void WriteName(TextWriter &writer, unsigned int name) const;
+	void WriteScalar(TextWriter &writer, unsigned int kind, unsigned int name, unsigned int index) const;
+	void WriteValue(TextWriter &writer, unsigned int kind, unsigned int index) const;
+	void WriteEnd(TextWriter &writer, unsigned int node) const;
+	void WritePool(TextWriter &writer, const PoolSpan &span) const;
+
+	unsigned int xmlSize;
+	PoolSpan prolog;
+	PoolSpan epilog;
+
+	std::vector<char> pool;
+	std::vector<PoolSpan> names;
+	std::vector<unsigned int> nameIds; //Hash table of names, only while building
+
+	std::vector<Node> nodes;
+	std::vector<Container> containers;
+
+	std::vector<unsigned char> u8s;
+	std::vector<signed char> s8s;
+	std::vector<unsigned short> u16s;
+	std::vector<short> s16s;
+	std::vector<unsigned int> u32s;
+	std::vector<int> s32s;
+	std::vector<unsigned long long> u64s;
+	std::vector<float> f32s;
+	std::vector<unsigned char> bools;
+	std::vector<PoolSpan> strings;
+	std::vector<float> vector3s; //x, y, z
+	std::vector<int> times; //year, month, day, hour, minute, second
+	std::vector<PoolSpan> raws; //Elements kept verbatim, from '<' to '>'
+};
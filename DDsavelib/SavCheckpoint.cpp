@@ -0,0 +1,98 @@
+// SavCheckpoint.cpp : Resumes repacking an edited save from just before the edit.
+//
+
+#include "SavCheckpoint.h"
+#include "SavAccess.h"
+#include "SavArena.h"
+#include "SavPackedCache.h"
+
+#include <new>
+#include <string.h>
+
+//Texts are compared a block at a time, then byte by byte inside the first block that differs
+#define SAVCHECKPOINT_COMPARESIZE (64 * 1024)
+
+void SavCheckpoint::Remember(const header_s *header, const unsigned char *text)
+{
+	if (this->text &&
+		this->header.hash == header->hash &&
+		this->header.realSize == header->realSize &&
+		this->header.compressedSize == header->compressedSize)
+	{
+		return;
+	}
+
+	Forget();
+	if (header->realSize > SAVCHECKPOINT_MAXSIZE)
+		return;
+	copy.reset(new (std::nothrow) unsigned char[header->realSize > 0 ? header->realSize : 1]);
+	if (!copy)
+		return;
+	memcpy(copy.get(), text, header->realSize);
+	this->header = *header;
+	this->text = copy.get();
+}
+
+void SavCheckpoint::Borrow(const header_s *header, const unsigned char *text)
+{
+	Forget();
+	this->header = *header;
+	this->text = text;
+}
+
+void SavCheckpoint::Forget()
+{
+	text = 0;
+	copy.reset();
+}
+
+bool SavCheckpoint::Matches(const unsigned char *data, unsigned int size, header_s *outHeader) const
+{
+	if (!text || header.realSize != size || memcmp(data, text, size) != 0)
+		return false;
+	*outHeader = header;
+	return true;
+}
+
+int SavCheckpoint::Find(	SavPackedCache &packed,
+							SavAccessCache &access,
+							SavArena &arena,
+							const unsigned char *data,
+							unsigned int size,
+							SavDeflateResume *outResume,
+							std::vector<SavAccessPoint> *outPoints) const
+{
+	if (!text)
+		return ERR_NOTCACHED;
+
+	unsigned int same = 0;
+	unsigned int common = size < header.realSize ? size : header.realSize;
+	while (same < common)
+	{
+		unsigned int block = common - same < SAVCHECKPOINT_COMPARESIZE ? common - same : SAVCHECKPOINT_COMPARESIZE;
+		if (memcmp(data + same, text + same, block) != 0)
+			break;
+		same += block;
+	}
+	while (same < common && data[same] == text[same])
+		++same;
+
+	//The first point is at the very start, where resuming saves nothing
+	if (!access.Copy(&header, same, outPoints) || outPoints->back().textOffset == 0)
+		return ERR_NOTCACHED;
+
+	unsigned char *compressed = 0;
+	int errcode = packed.Copy(&header, arena, &compressed);
+	if (errcode)
+		return errcode;
+
+	//The block before the point may end inside a byte, whose low bits the new blocks carry on from
+	const SavAccessPoint &point = outPoints->back();
+	outResume->prefix = compressed;
+	outResume->prefixSize = point.compressedOffset - (point.bits > 0 ? 1 : 0);
+	outResume->bits = point.bits > 0 ? 8 - point.bits : 0;
+	outResume->value = point.bits > 0 ? compressed[point.compressedOffset - 1] & ((1 << outResume->bits) - 1) : 0;
+	outResume->textOffset = point.textOffset;
+	outResume->adler = point.adler;
+	return 0;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "SavFormat.h"
+#include "SavDeflate.h"
+
+#include <memory>
+#include <vector>
+
+class SavAccessCache;
+class SavArena;
+class SavPackedCache;
+
+// Largest text a checkpoint copies; real saves are around 20 MB
+#define SAVCHECKPOINT_MAXSIZE (64 * 1024 * 1024)
+
+// The text of a save that is expected to be repacked, so repacking an edited copy of it can pick up where the
+// edit starts. The first byte that changed is found by comparing the two texts; the save's payload is then reused
+// as it is up to its last access point before that byte (see SavAccess), and only the text after the point is
+// compressed. An edit near the end of a save repacks in a few milliseconds.
+// A SavContext keeps a copy of the text SavContextUnpack gives out until its next SavContextRepack writes a save;
+// a SavDocument uses its own text in place. Like its owner, a checkpoint is used by one call at a time.
+class SavCheckpoint
+{
+public:
+	SavCheckpoint() : text(0) {}
+
+	// Keeps a copy of text, the whole unpacked text of the save with header, in place of any text kept before.
+	// A text larger than SAVCHECKPOINT_MAXSIZE, or that there is no memory for, isn't kept.
+	void Remember(const header_s *header, const unsigned char *text);
+	// Like Remember, but uses text where it is; it must stay alive and unchanged until Forget or the end
+	void Borrow(const header_s *header, const unsigned char *text);
+	// Lets go of the text, freeing it if it was copied
+	void Forget();
+
+	// Whether data is exactly the text, compared byte for byte; outHeader gets that save's header
+	bool Matches(const unsigned char *data, unsigned int size, header_s *outHeader) const;
+
+	// Works out how to repack data by resuming from the save, with its payload, from packed, copied into arena.
+	// outPoints gets the save's access points in access up to and including the one resumed from.
+	// Returns 0, ERR_NOTCACHED if there is nothing to resume from (no text is kept, the save's payload or access
+	// points have been forgotten, or data differs from it before its second access point), or ERR_MEMORY.
+	int Find(	SavPackedCache &packed,
+				SavAccessCache &access,
+				SavArena &arena,
+				const unsigned char *data,
+				unsigned int size,
+				SavDeflateResume *outResume,
+				std::vector<SavAccessPoint> *outPoints) const;
+
+private:
+	SavCheckpoint(const SavCheckpoint &);
+	SavCheckpoint &operator=(const SavCheckpoint &);
+
+	header_s header;
+	const unsigned char *text; //Null until a text is kept
+	std::unique_ptr<unsigned char[]> copy; //The text, when it was copied
+};
@@ -0,0 +1,126 @@
+// SavContext.cpp : Zlib streams kept open between saves.
+//
+
+#include "SavContext.h"
+#include "easyzlib.h"
+
+#include <new>
+
+SavStreamCache::~SavStreamCache()
+{
+	for (ezstream *stream : inflates)
+		ezinflateclose(stream);
+	for (ezstream *stream : rawInflates)
+		ezinflateclose(stream);
+	for (ezstream *stream : deflates)
+		ezdeflateclose(stream);
+	for (SavArena *arena : arenas)
+		delete arena;
+}
+
+ezstream *SavStreamCache::AcquireInflate()
+{
+	ezstream *stream = 0;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!inflates.empty())
+		{
+			stream = inflates.back();
+			inflates.pop_back();
+		}
+	}
+
+	if (stream && ezinflatereset(stream) != 0)
+	{
+		ezinflateclose(stream);
+		stream = 0;
+	}
+	return stream ? stream : ezinflateopen2(SavArena::ZAlloc, SavArena::ZFree, &streamArena);
+}
+
+void SavStreamCache::ReleaseInflate(ezstream *stream)
+{
+	if (!stream)
+		return;
+	std::lock_guard<std::mutex> guard(lock);
+	inflates.push_back(stream);
+}
+
+ezstream *SavStreamCache::AcquireRawInflate()
+{
+	ezstream *stream = 0;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!rawInflates.empty())
+		{
+			stream = rawInflates.back();
+			rawInflates.pop_back();
+		}
+	}
+
+	if (stream && ezinflatereset(stream) != 0)
+	{
+		ezinflateclose(stream);
+		stream = 0;
+	}
+	return stream ? stream : ezrawinflateopen2(SavArena::ZAlloc, SavArena::ZFree, &streamArena);
+}
+
+void SavStreamCache::ReleaseRawInflate(ezstream *stream)
+{
+	if (!stream)
+		return;
+	std::lock_guard<std::mutex> guard(lock);
+	rawInflates.push_back(stream);
+}
+
+ezstream *SavStreamCache::AcquireDeflate(int level, int strategy)
+{
+	ezstream *stream = 0;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!deflates.empty())
+		{
+			stream = deflates.back();
+			deflates.pop_back();
+		}
+	}
+
+	if (stream && ezdeflatereset(stream, level, strategy) != 0)
+	{
+		ezdeflateclose(stream);
+		stream = 0;
+	}
+	return stream ? stream : ezrawdeflateopen2(level, strategy, SavArena::ZAlloc, SavArena::ZFree, &streamArena);
+}
+
+void SavStreamCache::ReleaseDeflate(ezstream *stream)
+{
+	if (!stream)
+		return;
+	std::lock_guard<std::mutex> guard(lock);
+	deflates.push_back(stream);
+}
+
+SavArena *SavStreamCache::AcquireArena()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (!arenas.empty())
+		{
+			SavArena *arena = arenas.back();
+			arenas.pop_back();
+			return arena;
+		}
+	}
+	return new (std::nothrow) SavArena();
+}
+
+void SavStreamCache::ReleaseArena(SavArena *arena)
+{
+	if (!arena)
+		return;
+	arena->Reset();
+	std::lock_guard<std::mutex> guard(lock);
+	arenas.push_back(arena);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "SavAccess.h"
+#include "SavArena.h"
+#include "SavCheckpoint.h"
+#include "SavPackedCache.h"
+#include "SavThreadPool.h"
+
+#include <mutex>
+#include <vector>
+
+struct ezstream;
+
+// Zlib streams waiting to be used again. Opening one allocates its window and hash tables (about
+// 256 KB for deflate), so streams are reset and handed out again instead of closed after each save.
+// All of zlib's memory for them comes from one arena kept with the cache, which reuses the memory of
+// a stream that had to be closed instead of reset. The cache also holds the arenas each save takes
+// its own buffers from, reset as they are handed back.
+// Safe to use from several threads at once; each thread gets a stream of its own.
+class SavStreamCache
+{
+public:
+	SavStreamCache() {}
+	~SavStreamCache();
+
+	// A zlib inflate stream ready for a new payload, or null if one couldn't be opened
+	ezstream *AcquireInflate();
+	void ReleaseInflate(ezstream *stream);
+
+	// A raw inflate stream, for entering a payload part way through, or null if one couldn't be opened
+	ezstream *AcquireRawInflate();
+	void ReleaseRawInflate(ezstream *stream);
+
+	// A raw deflate stream set to level and strategy, or null if one couldn't be opened
+	ezstream *AcquireDeflate(int level, int strategy);
+	void ReleaseDeflate(ezstream *stream);
+
+	// An empty arena for one save's buffers, or null if one couldn't be allocated
+	SavArena *AcquireArena();
+	void ReleaseArena(SavArena *arena);
+
+private:
+	SavStreamCache(const SavStreamCache &);
+	SavStreamCache &operator=(const SavStreamCache &);
+
+	SavArena streamArena; //Where the streams' state, windows and tables live
+	std::mutex lock;
+	std::vector<ezstream *> inflates;
+	std::vector<ezstream *> rawInflates;
+	std::vector<ezstream *> deflates;
+	std::vector<SavArena *> arenas;
+};
+
+// What a SavContext or SavDocument remembers of the saves that went through it: their payloads, to write one
+// back unchanged, their access points, to inflate part of one or resume compressing it, and the text expected
+// to be repacked, to resume an edit of it
+struct SavSaveCache
+{
+	SavPackedCache packed;
+	SavAccessCache access;
+	SavCheckpoint checkpoint;
+};
+
+// What a caller keeps between saves: the zlib streams and the threads that compress on them, and the saves
+// unpacked and written through the SavContext exports
+struct SavContext
+{
+	explicit SavContext(unsigned int threadCount) : pool(threadCount) {}
+
+	SavThreadPool pool;
+	SavStreamCache streams;
+	SavSaveCache saves; //Only filled by the SavContext exports, not by calls that share the context
+};
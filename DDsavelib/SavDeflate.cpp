@@ -0,0 +1,328 @@
+// SavDeflate.cpp : Compresses one zlib stream in independent pieces on several threads.
+//
+
+#include "SavDeflate.h"
+#include "SavFormat.h"
+#include "SavContext.h"
+#include "easyzlib.h"
+
+#include <atomic>
+#include <string.h>
+
+namespace
+{
+	//Output of a piece that is only being counted is written here and overwritten
+	#define DISCARD_SIZE (16 * 1024)
+
+	struct Piece
+	{
+		unsigned char *compressed; //In the arena, or null when only counted
+		unsigned int size;
+		unsigned long adler;
+		int errcode;
+	};
+
+	// Raw deflate of one piece, primed with up to EZ_DICTIONARYSIZE bytes of what comes before it,
+	// and with its output started by primeBits bits of primeValue.
+	// The output is kept in arena, or if arena is null, only counted.
+	int DeflatePiece(	SavStreamCache &streams,
+						SavArena *arena,
+						const unsigned char *dictionary,
+						unsigned int dictionarySize,
+						int primeBits,
+						int primeValue,
+						const unsigned char *data,
+						unsigned int size,
+						bool last,
+						int level,
+						int strategy,
+						Piece *outPiece)
+	{
+		outPiece->compressed = 0;
+		outPiece->size = 0;
+		ezstream *stream = streams.AcquireDeflate(level, strategy);
+		if (!stream)
+			return ERR_MEMORY;
+
+		int errcode = 0;
+		if (dictionarySize > 0 && ezdeflatedictionary(stream, dictionary, (long)dictionarySize) != 0)
+			errcode = ERR_STREAM;
+		if (primeBits > 0 && ezdeflateprime(stream, primeBits, primeValue) != 0)
+			errcode = ERR_STREAM;
+
+		unsigned char discard[DISCARD_SIZE];
+		unsigned char *out = discard;
+		unsigned int capacity = DISCARD_SIZE;
+		if (arena)
+		{
+			//Room for the worst case, plus the empty stored block a sync flush ends with
+			capacity = EZ_COMPRESSMAXDESTLENGTH(size) + 8;
+			out = (unsigned char *)arena->Allocate(capacity);
+			if (!out)
+				errcode = ERR_MEMORY;
+		}
+
+		unsigned int used = 0;
+		unsigned int counted = 0;
+		int flush = last ? EZ_FINISH : EZ_SYNC_FLUSH;
+		while (!errcode)
+		{
+			long inLen = (long)size;
+			long outLen = (long)(capacity - used);
+			int zcode = ezdeflatestream(stream, out + used, &outLen, data, &inLen, flush);
+			data += inLen;
+			size -= (unsigned int)inLen;
+			used += (unsigned int)outLen;
+
+			if (zcode < 0 && zcode != EZ_BUF_ERROR)
+			{
+				errcode = zcode;
+			}
+			else if (zcode == EZ_STREAM_END || (!last && size == 0 && used < capacity))
+			{
+				//A sync flush is done once it has consumed everything and left output space over
+				break;
+			}
+			else if (!arena)
+			{
+				counted += used;
+				used = 0;
+			}
+			else
+			{
+				unsigned char *grown = (unsigned char *)arena->Allocate(capacity * 2);
+				if (!grown)
+				{
+					errcode = ERR_MEMORY;
+					break;
+				}
+				memcpy(grown, out, used);
+				out = grown;
+				capacity *= 2;
+			}
+		}
+
+		streams.ReleaseDeflate(stream);
+		if (arena && out)
+		{
+			arena->Trim(out, capacity, used);
+			outPiece->compressed = out;
+		}
+		outPiece->size = counted + used;
+		return errcode;
+	}
+
+	// The FLEVEL field of the zlib header deflate writes for level: 0 for the fastest levels up to 3 for the smallest
+	unsigned int LevelFlags(int level, int strategy)
+	{
+		if (level == EZ_DEFAULT_COMPRESSION)
+			level = 6;
+		if (strategy >= 2 || level < 2)
+			return 0;
+		if (level < 6)
+			return 1;
+		return level == 6 ? 2 : 3;
+	}
+
+	// The two-byte zlib header deflate would write for level, with no preset dictionary
+	void WriteZlibHeader(int level, int strategy, unsigned char *out)
+	{
+		unsigned int header = (0x78 << 8) | (LevelFlags(level, strategy) << 6);
+		header += 31 - header % 31;
+		out[0] = (unsigned char)(header >> 8);
+		out[1] = (unsigned char)header;
+	}
+
+	unsigned int PieceCount(unsigned int size)
+	{
+		return size / SAVDEFLATE_PIECESIZE + (size % SAVDEFLATE_PIECESIZE != 0 || size == 0);
+	}
+
+	unsigned int PieceSize(unsigned int size, unsigned int i)
+	{
+		unsigned int start = i * SAVDEFLATE_PIECESIZE;
+		return size - start < SAVDEFLATE_PIECESIZE ? size - start : SAVDEFLATE_PIECESIZE;
+	}
+
+	// The pieces of one stream and what the threads compressing them share. The pool's tasks only
+	// capture a pointer to it, small enough for std::function to hold without allocating.
+	struct PieceJob
+	{
+		const unsigned char *data; //The pieces cover size bytes from here on
+		unsigned int size;
+		unsigned int offset; //Where data is in the whole text, which goes on before it for the dictionary
+		int primeBits; //Carried into the first piece's output
+		int primeValue;
+		int level;
+		int strategy;
+		SavStreamCache *streams;
+		SavArena *output; //Null to only count each piece's output
+		unsigned long long capacity;
+		Piece *pieces;
+		unsigned int pieceCount;
+		std::atomic<unsigned long long> streamSize;
+
+		void Run(unsigned int i)
+		{
+			Piece &piece = pieces[i];
+			if (streamSize.load() > capacity)
+			{
+				piece.compressed = 0;
+				piece.size = 0;
+				piece.errcode = ERR_TOOLARGE;
+				return;
+			}
+
+			unsigned int start = i * SAVDEFLATE_PIECESIZE;
+			unsigned int pieceSize = PieceSize(size, i);
+			unsigned int dictionarySize = offset + start < EZ_DICTIONARYSIZE ? offset + start : EZ_DICTIONARYSIZE;
+
+			piece.adler = ezadler32(1, data + start, (long)pieceSize);
+			piece.errcode = DeflatePiece(	*streams,
+											output,
+											data + start - dictionarySize,
+											dictionarySize,
+											i == 0 ? primeBits : 0,
+											primeValue,
+											data + start,
+											pieceSize,
+											i + 1 == pieceCount,
+											level,
+											strategy,
+											&piece);
+			streamSize += piece.size;
+		}
+	};
+
+	// Compresses every piece on context's threads, giving the size of the stream they make up.
+	// Once the pieces done so far are already too long for capacity, the rest are skipped and
+	// ERR_TOOLARGE is returned. The pieces are kept in arena if keep is set, and only counted if not.
+	// With resume, the pieces start at its point and the stream with its prefix.
+	int DeflatePieces(	const unsigned char *data,
+						unsigned int size,
+						const SavDeflateResume *resume,
+						int level,
+						int strategy,
+						SavContext &context,
+						SavArena &arena,
+						unsigned long long capacity,
+						bool keep,
+						Piece **outPieces,
+						unsigned long long *outStreamSize)
+	{
+		PieceJob job;
+		job.offset = resume ? resume->textOffset : 0;
+		job.data = data + job.offset;
+		job.size = size - job.offset;
+		job.primeBits = resume ? resume->bits : 0;
+		job.primeValue = resume ? resume->value : 0;
+		job.level = level;
+		job.strategy = strategy;
+		job.streams = &context.streams;
+		job.output = keep ? &arena : 0;
+		job.capacity = capacity;
+		job.pieceCount = PieceCount(job.size);
+		job.pieces = (Piece *)arena.Allocate(sizeof(Piece) * job.pieceCount);
+		if (!job.pieces)
+			return ERR_MEMORY;
+		//Zlib header or the resumed prefix, and the trailer
+		job.streamSize = (resume ? resume->prefixSize : 2) + 4;
+
+		PieceJob *shared = &job;
+		context.pool.For(job.pieceCount, [shared](unsigned int i) { shared->Run(i); });
+
+		for (unsigned int i = 0; i < job.pieceCount; ++i)
+		{
+			if (job.pieces[i].errcode && job.pieces[i].errcode != ERR_TOOLARGE)
+				return job.pieces[i].errcode;
+		}
+		*outPieces = job.pieces;
+		*outStreamSize = job.streamSize.load();
+		return *outStreamSize > capacity ? ERR_TOOLARGE : 0;
+	}
+}
+
+bool CanResume(const SavDeflateResume &resume, int level, int strategy)
+{
+	return resume.prefixSize >= 2 && (unsigned int)(resume.prefix[1] >> 6) >= LevelFlags(level, strategy);
+}
+
+int ParallelDeflate(	const unsigned char *data,
+						unsigned int size,
+						int level,
+						int strategy,
+						SavContext &context,
+						SavArena &arena,
+						unsigned int capacity,
+						unsigned char **outStream,
+						unsigned int *outStreamSize,
+						const SavDeflateResume *resume,
+						std::vector<SavAccessPoint> *outPoints)
+{
+	Piece *pieces = 0;
+	unsigned long long streamSize = 0;
+	int errcode = DeflatePieces(data, size, resume, level, strategy, context, arena, capacity, true, &pieces, &streamSize);
+	if (errcode)
+		return errcode;
+
+	unsigned char *stream = (unsigned char *)arena.Allocate((size_t)streamSize);
+	if (!stream)
+		return ERR_MEMORY;
+	unsigned char *out = stream;
+	unsigned int offset = 0;
+	unsigned long adler = 1;
+	if (resume)
+	{
+		memcpy(out, resume->prefix, resume->prefixSize);
+		out += resume->prefixSize;
+		offset = resume->textOffset;
+		adler = resume->adler;
+	}
+	else
+	{
+		WriteZlibHeader(level, strategy, out);
+		out += 2;
+	}
+
+	unsigned int pieceCount = PieceCount(size - offset);
+	for (unsigned int i = 0; i < pieceCount; ++i)
+	{
+		//A sync flush leaves each later piece starting on a byte, at the start of a block. A resumed
+		//first piece starts wherever the prefix left off, at a point the earlier save already had.
+		unsigned int start = offset + i * SAVDEFLATE_PIECESIZE;
+		bool boundary = i > 0 || !resume;
+		if (outPoints && boundary && (outPoints->empty() || start - outPoints->back().textOffset >= SAVACCESS_SPAN))
+		{
+			SavAccessPoint point = { start, (unsigned int)(out - stream), 0, adler };
+			outPoints->push_back(point);
+		}
+
+		const Piece &piece = pieces[i];
+		memcpy(out, piece.compressed, piece.size);
+		out += piece.size;
+		unsigned int pieceSize = PieceSize(size - offset, i);
+		adler = i == 0 && !resume ? piece.adler : ezadler32combine(adler, piece.adler, (long)pieceSize);
+	}
+
+	//The trailer is big-endian
+	out[0] = (unsigned char)(adler >> 24);
+	out[1] = (unsigned char)(adler >> 16);
+	out[2] = (unsigned char)(adler >> 8);
+	out[3] = (unsigned char)adler;
+
+	*outStream = stream;
+	*outStreamSize = (unsigned int)streamSize;
+	return 0;
+}
+
+int MeasureParallelDeflate(	const unsigned char *data,
+							unsigned int size,
+							int level,
+							int strategy,
+							SavContext &context,
+							SavArena &arena,
+							unsigned long long *outStreamSize)
+{
+	Piece *pieces = 0;
+	return DeflatePieces(data, size, 0, level, strategy, context, arena, ~0ULL, false, &pieces, outStreamSize);
+}
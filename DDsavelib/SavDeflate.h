@@ -0,0 +1,61 @@
+#pragma once
+
+#include "SavAccess.h"
+
+#include <vector>
+
+class SavArena;
+struct SavContext;
+
+// Input is split into pieces of this size, each compressed on its own
+#define SAVDEFLATE_PIECESIZE (128 * 1024)
+
+// Where a stream carries on from an earlier save's payload instead of starting afresh: the payload up to
+// one of its access points is copied as it is, and only the text from that point on is compressed.
+// The earlier save's text must be the same as the new text up to the point.
+struct SavDeflateResume
+{
+	const unsigned char *prefix; //The earlier payload, zlib header included
+	unsigned int prefixSize; //Whole bytes of it before the point
+	int bits; //Bits of the byte after those that come before the point, 0 if the point is on a byte
+	int value; //Those bits, in the low bits
+	unsigned int textOffset; //The point's offset in the text
+	unsigned long adler; //Adler-32 of the text before the point
+};
+
+// Whether resume's prefix was compressed at least as hard as level and strategy would, going by the level
+// its zlib header gives, so resuming from it doesn't leave a larger stream than asked for
+bool CanResume(const SavDeflateResume &resume, int level, int strategy);
+
+// Compresses data into a single zlib stream on context's threads and streams, pigz-style. Each piece of
+// SAVDEFLATE_PIECESIZE bytes is raw deflate primed with the 32 KB of input before it and ended with
+// a sync flush, so the pieces join into one valid stream between the usual zlib header and an
+// Adler-32 trailer combined from the pieces' own. Carrying the dictionary keeps the output within
+// a fraction of a percent of compressing it all in one go.
+// The stream and the pieces it was joined from are allocated in arena; *outStream points to it.
+// Returns 0, or ERR_MEMORY or a zlib error, or ERR_TOOLARGE as soon as the stream is known to be
+// longer than capacity bytes, without compressing the rest.
+// With resume, the stream starts with resume's prefix and the pieces cover the text after its point.
+// outPoints, if given, gets the stream's access points at piece boundaries about every SAVACCESS_SPAN;
+// with resume, it should already hold the earlier save's points up to resume's.
+int ParallelDeflate(	const unsigned char *data,
+						unsigned int size,
+						int level,
+						int strategy,
+						SavContext &context,
+						SavArena &arena,
+						unsigned int capacity,
+						unsigned char **outStream,
+						unsigned int *outStreamSize,
+						const SavDeflateResume *resume = 0,
+						std::vector<SavAccessPoint> *outPoints = 0);
+
+// Gives the exact size ParallelDeflate's stream would have, however large, only counting each
+// piece's output rather than keeping it.
+int MeasureParallelDeflate(	const unsigned char *data,
+							unsigned int size,
+							int level,
+							int strategy,
+							SavContext &context,
+							SavArena &arena,
+							unsigned long long *outStreamSize);
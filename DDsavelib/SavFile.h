@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+
+// A file read and written at explicit offsets, so no call depends on a shared file position.
+// SavFileWin32.cpp implements it on Win32 handles, SavFilePosix.cpp on open/pread/pwrite;
+// a build compiles exactly one of them.
+class SavFile
+{
+public:
+	SavFile();
+	~SavFile(); //Closes the file if Close wasn't called
+
+	// Opens an existing file. Returns ERR_READ if it can't be opened.
+	int OpenRead(const char *path);
+	// Creates a file, or empties an existing one. Returns ERR_WRITE if it can't be opened.
+	int OpenWrite(const char *path);
+
+	// Returns ERR_READ if the size can't be read, or ERR_FORMAT if the file is 4 GB or more
+	int GetSize(unsigned int *outSize) const;
+	// Reads up to size bytes at offset; *outRead gets how many there were before the end of the file
+	int ReadAt(unsigned int offset, void *data, unsigned int size, unsigned int *outRead) const;
+	// Writes all size bytes at offset, or returns ERR_WRITE
+	int WriteAt(unsigned int offset, const void *data, unsigned int size);
+
+	// Returns ERR_WRITE if closing a written file fails, since it may not have been saved
+	int Close();
+
+private:
+	friend class SavMappedFile;
+
+	SavFile(const SavFile &);
+	SavFile &operator=(const SavFile &);
+
+	intptr_t handle; //HANDLE on Win32, file descriptor on POSIX; -1 when closed
+	bool writable;
+};
+
+// A whole file mapped read-only, so its bytes are read straight from the page cache without a copy.
+// Only the pages actually touched are read from disk. The file must not shrink while it is mapped.
+class SavMappedFile
+{
+public:
+	SavMappedFile();
+	~SavMappedFile();
+
+	// Returns ERR_READ if the file can't be opened or mapped, or ERR_FORMAT if it is 4 GB or more
+	int Open(const char *path);
+	void Close();
+
+	const unsigned char *GetData() const { return data; }
+	unsigned int GetSize() const { return size; }
+
+private:
+	SavMappedFile(const SavMappedFile &);
+	SavMappedFile &operator=(const SavMappedFile &);
+
+	const unsigned char *data; //Null for an empty file, which can't be mapped
+	unsigned int size;
+};
@@ -0,0 +1,163 @@
+// SavFilePosix.cpp : SavFile on POSIX file descriptors.
+//
+
+#ifndef _WIN32
+
+#include "SavFile.h"
+#include "SavFormat.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+SavFile::SavFile() : handle(-1), writable(false)
+{
+}
+
+SavFile::~SavFile()
+{
+	Close();
+}
+
+int SavFile::OpenRead(const char *path)
+{
+	Close();
+	int fd;
+	do
+	{
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+	} while (fd < 0 && errno == EINTR);
+	if (fd < 0)
+		return ERR_READ;
+
+	handle = fd;
+	writable = false;
+	return 0;
+}
+
+int SavFile::OpenWrite(const char *path)
+{
+	Close();
+	int fd;
+	do
+	{
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	} while (fd < 0 && errno == EINTR);
+	if (fd < 0)
+		return ERR_WRITE;
+
+	handle = fd;
+	writable = true;
+	return 0;
+}
+
+int SavFile::GetSize(unsigned int *outSize) const
+{
+	struct stat info;
+	if (fstat((int)handle, &info) != 0)
+		return ERR_READ;
+	if ((unsigned long long)info.st_size > 0xFFFFFFFF)
+		return ERR_FORMAT;
+
+	*outSize = (unsigned int)info.st_size;
+	return 0;
+}
+
+int SavFile::ReadAt(unsigned int offset, void *data, unsigned int size, unsigned int *outRead) const
+{
+	unsigned char *bytes = (unsigned char *)data;
+	unsigned int total = 0;
+	while (total < size)
+	{
+		ssize_t count = pread((int)handle, bytes + total, size - total, (off_t)offset + total);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			*outRead = total;
+			return ERR_READ;
+		}
+		if (count == 0)
+			break;
+		total += (unsigned int)count;
+	}
+	*outRead = total;
+	return 0;
+}
+
+int SavFile::WriteAt(unsigned int offset, const void *data, unsigned int size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	unsigned int total = 0;
+	while (total < size)
+	{
+		ssize_t count = pwrite((int)handle, bytes + total, size - total, (off_t)offset + total);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			return ERR_WRITE;
+		}
+		total += (unsigned int)count;
+	}
+	return 0;
+}
+
+int SavFile::Close()
+{
+	if (handle < 0)
+		return 0;
+
+	//Retrying close after EINTR could close a descriptor another thread just opened
+	int result = close((int)handle);
+	handle = -1;
+	return result != 0 && writable && errno != EINTR ? ERR_WRITE : 0;
+}
+
+SavMappedFile::SavMappedFile() : data(0), size(0)
+{
+}
+
+SavMappedFile::~SavMappedFile()
+{
+	Close();
+}
+
+int SavMappedFile::Open(const char *path)
+{
+	Close();
+	SavFile file;
+	int errcode = file.OpenRead(path);
+	if (errcode)
+		return errcode;
+
+	unsigned int fileSize = 0;
+	errcode = file.GetSize(&fileSize);
+	if (errcode || fileSize == 0)
+		return errcode;
+
+	//The mapping stays valid after the descriptor is closed
+	void *view = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, (int)file.handle, 0);
+	if (view == MAP_FAILED)
+		return ERR_READ;
+
+	data = (const unsigned char *)view;
+	size = fileSize;
+	return 0;
+}
+
+void SavMappedFile::Close()
+{
+	if (data)
+		munmap((void *)data, size);
+	data = 0;
+	size = 0;
+}
+
+#endif
@@ -0,0 +1,155 @@
+// SavFileWin32.cpp : SavFile on Win32 file handles.
+//
+
+#ifdef _WIN32
+
+#include "SavFile.h"
+#include "SavFormat.h"
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+SavFile::SavFile() : handle(-1), writable(false)
+{
+}
+
+SavFile::~SavFile()
+{
+	Close();
+}
+
+int SavFile::OpenRead(const char *path)
+{
+	Close();
+	//Others may keep reading and writing the file, as they could while the CRT had it open
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, 0,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return ERR_READ;
+
+	handle = (intptr_t)file;
+	writable = false;
+	return 0;
+}
+
+int SavFile::OpenWrite(const char *path)
+{
+	Close();
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, FILE_SHARE_READ, 0,
+		CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return ERR_WRITE;
+
+	handle = (intptr_t)file;
+	writable = true;
+	return 0;
+}
+
+int SavFile::GetSize(unsigned int *outSize) const
+{
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx((HANDLE)handle, &size))
+		return ERR_READ;
+	if ((unsigned long long)size.QuadPart > 0xFFFFFFFF)
+		return ERR_FORMAT;
+
+	*outSize = (unsigned int)size.QuadPart;
+	return 0;
+}
+
+int SavFile::ReadAt(unsigned int offset, void *data, unsigned int size, unsigned int *outRead) const
+{
+	unsigned char *bytes = (unsigned char *)data;
+	unsigned int total = 0;
+	while (total < size)
+	{
+		//On a synchronous handle, the offset in OVERLAPPED is where the read starts
+		OVERLAPPED at = {};
+		at.Offset = offset + total;
+		DWORD count = 0;
+		if (!::ReadFile((HANDLE)handle, bytes + total, size - total, &count, &at))
+		{
+			if (GetLastError() == ERROR_HANDLE_EOF)
+				break;
+			*outRead = total;
+			return ERR_READ;
+		}
+		if (count == 0)
+			break;
+		total += count;
+	}
+	*outRead = total;
+	return 0;
+}
+
+int SavFile::WriteAt(unsigned int offset, const void *data, unsigned int size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+	unsigned int total = 0;
+	while (total < size)
+	{
+		OVERLAPPED at = {};
+		at.Offset = offset + total;
+		DWORD count = 0;
+		if (!::WriteFile((HANDLE)handle, bytes + total, size - total, &count, &at) || count == 0)
+			return ERR_WRITE;
+		total += count;
+	}
+	return 0;
+}
+
+int SavFile::Close()
+{
+	if (handle == -1)
+		return 0;
+
+	BOOL closed = CloseHandle((HANDLE)handle);
+	handle = -1;
+	return !closed && writable ? ERR_WRITE : 0;
+}
+
+SavMappedFile::SavMappedFile() : data(0), size(0)
+{
+}
+
+SavMappedFile::~SavMappedFile()
+{
+	Close();
+}
+
+int SavMappedFile::Open(const char *path)
+{
+	Close();
+	SavFile file;
+	int errcode = file.OpenRead(path);
+	if (errcode)
+		return errcode;
+
+	unsigned int fileSize = 0;
+	errcode = file.GetSize(&fileSize);
+	if (errcode || fileSize == 0)
+		return errcode;
+
+	//The view keeps the mapping and the file open once their handles are closed
+	HANDLE mapping = CreateFileMappingA((HANDLE)file.handle, 0, PAGE_READONLY, 0, 0, 0);
+	if (!mapping)
+		return ERR_READ;
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view)
+		return ERR_READ;
+
+	data = (const unsigned char *)view;
+	size = fileSize;
+	return 0;
+}
+
+void SavMappedFile::Close()
+{
+	if (data)
+		UnmapViewOfFile(data);
+	data = 0;
+	size = 0;
+}
+
+#endif
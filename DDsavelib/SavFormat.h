@@ -0,0 +1,37 @@
+#pragma once
+
+// Layout of a packed .sav file and the error codes shared by DDsavelib's source files
+
+//Size of full file is always 524288 (extra data are nulls)
+#define SAVESIZE 524288
+
+extern int ERR_READ;
+extern int ERR_WRITE;
+extern int ERR_FORMAT;
+extern int ERR_UNPACK;
+extern int ERR_BUFFERSIZE;
+extern int ERR_ABORTED;
+extern int ERR_CHECKSUM;
+extern int ERR_PATH;
+extern int ERR_TOOLARGE;
+extern int ERR_ARGUMENT;
+extern int ERR_STREAM;
+extern int ERR_DATA;
+extern int ERR_MEMORY;
+extern int ERR_BUFFER;
+//Never returned by an export: one of the caches of recent saves doesn't hold what was asked for
+extern int ERR_NOTCACHED;
+
+#pragma pack(push, 1)
+struct header_s
+{
+	unsigned int u1; //Version (21 for DDDA console and DDDA PC, and 5 for original DD on console)
+	unsigned int realSize; //Real size of compressed save game data
+	unsigned int compressedSize;
+	unsigned int u2; //Always 860693325
+	unsigned int u3; //Always 0
+	unsigned int u4; //Always 860700740
+	unsigned int hash; //Checksum of compressed save data
+	unsigned int u5; //Always 1079398965
+};
+#pragma pack(pop)
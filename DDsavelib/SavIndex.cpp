@@ -0,0 +1,125 @@
+// SavIndex.cpp : Sidecar cache of value attribute offsets for packed saves.
+//
+
+#include "SavIndex.h"
+#include "SavFormat.h"
+#include "Crc32.h"
+#include "SavFile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	//"SIDX"
+	const unsigned int IndexMagic = 0x58444953;
+	//2: paths match the first element they could, and by name before index
+	const unsigned int IndexVersion = 2;
+
+#pragma pack(push, 1)
+	struct IndexHeader
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int saveHash; //header_s::hash of the save the spans were found in
+		unsigned int realSize;
+		unsigned int pathCount;
+		unsigned int pathsHash; //Checksum of the paths, each with its terminator
+		unsigned int spansHash; //Checksum of the spans that follow
+	};
+#pragma pack(pop)
+
+	unsigned int HashPaths(const char *const *paths, unsigned int pathCount)
+	{
+		unsigned int hash = 0xFFFFFFFF;
+		for (unsigned int i = 0; i < pathCount; ++i)
+		{
+			hash = crc32jam((const unsigned char *)paths[i], strlen(paths[i]) + 1, hash);
+		}
+		return hash;
+	}
+}
+
+int LoadSavIndex(	const char *indexPath,
+					unsigned int saveHash,
+					unsigned int realSize,
+					const char *const *paths,
+					unsigned int pathCount,
+					SavValueSpan *outSpans)
+{
+	SavFile file;
+	if (file.OpenRead(indexPath) != 0)
+		return ERR_READ;
+
+	IndexHeader header;
+	unsigned int headerSize = 0;
+	int errcode = 0;
+	if (file.ReadAt(0, &header, sizeof(header), &headerSize) != 0 ||
+		headerSize != sizeof(header) ||
+		header.magic != IndexMagic ||
+		header.version != IndexVersion)
+	{
+		errcode = ERR_FORMAT;
+	}
+	else if (header.saveHash != saveHash ||
+		header.realSize != realSize ||
+		header.pathCount != pathCount ||
+		header.pathsHash != HashPaths(paths, pathCount))
+	{
+		errcode = ERR_CHECKSUM;
+	}
+	else
+	{
+		unsigned int spansSize = pathCount * sizeof(SavValueSpan);
+		unsigned int readSize = 0;
+		if (file.ReadAt(sizeof(header), outSpans, spansSize, &readSize) != 0 || readSize != spansSize)
+			errcode = ERR_FORMAT;
+	}
+	file.Close();
+
+	if (!errcode && header.spansHash != crc32jam((const unsigned char *)outSpans, pathCount * sizeof(SavValueSpan)))
+		errcode = ERR_CHECKSUM;
+
+	//Spans outside the text would send callers out of bounds, so the whole index is thrown out
+	for (unsigned int i = 0; !errcode && i < pathCount; ++i)
+	{
+		if (outSpans[i].offset != SAVPATH_NOTFOUND &&
+			(outSpans[i].offset > realSize || outSpans[i].size > realSize - outSpans[i].offset))
+		{
+			errcode = ERR_FORMAT;
+		}
+	}
+	return errcode;
+}
+
+int SaveSavIndex(	const char *indexPath,
+					unsigned int saveHash,
+					unsigned int realSize,
+					const char *const *paths,
+					unsigned int pathCount,
+					const SavValueSpan *spans)
+{
+	SavFile file;
+	if (file.OpenWrite(indexPath) != 0)
+		return ERR_WRITE;
+
+	IndexHeader header;
+	header.magic = IndexMagic;
+	header.version = IndexVersion;
+	header.saveHash = saveHash;
+	header.realSize = realSize;
+	header.pathCount = pathCount;
+	header.pathsHash = HashPaths(paths, pathCount);
+	header.spansHash = crc32jam((const unsigned char *)spans, pathCount * sizeof(SavValueSpan));
+
+	int errcode = file.WriteAt(0, &header, sizeof(header));
+	if (!errcode)
+		errcode = file.WriteAt(sizeof(header), spans, pathCount * sizeof(SavValueSpan));
+	if (file.Close() != 0 && !errcode)
+		errcode = ERR_WRITE;
+
+	//A half-written index would only be rejected later, so don't leave one behind
+	if (errcode)
+		remove(indexPath);
+	return errcode;
+}
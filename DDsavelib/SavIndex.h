@@ -0,0 +1,27 @@
+#pragma once
+
+#include "DDsavelib.h"
+
+// A sidecar file caching where SavPathMatcher found a list of paths in one packed save, so opening
+// the same save again with the same paths can skip the scan. It is keyed by the save's header hash
+// and realSize, and by a checksum of the path list; any mismatch just makes it a miss.
+
+// Path of the index file kept next to a packed save
+#define SAVINDEX_EXTENSION ".idx"
+
+// Fills outSpans from the index at indexPath. Returns 0 on a hit, or nonzero if the file is missing,
+// damaged, or was written for a different save or path list.
+int LoadSavIndex(	const char *indexPath,
+					unsigned int saveHash,
+					unsigned int realSize,
+					const char *const *paths,
+					unsigned int pathCount,
+					SavValueSpan *outSpans);
+
+// Writes the index for the save with the given hash and realSize, replacing any old one
+int SaveSavIndex(	const char *indexPath,
+					unsigned int saveHash,
+					unsigned int realSize,
+					const char *const *paths,
+					unsigned int pathCount,
+					const SavValueSpan *spans);
@@ -0,0 +1,168 @@
+// SavPackedCache.cpp : Remembers a context's recent saves so unchanged text is never compressed twice.
+//
+
+#include "SavPackedCache.h"
+#include "SavArena.h"
+#include "SavContext.h"
+#include "easyzlib.h"
+
+#include <new>
+#include <string.h>
+
+//Compared against the text a window at a time
+#define SAVPACKEDCACHE_WINDOWSIZE (64 * 1024)
+
+namespace
+{
+	//The trailer is big-endian
+	unsigned long TrailerAdler(const unsigned char *compressedData, unsigned int compressedSize)
+	{
+		const unsigned char *trailer = compressedData + compressedSize - 4;
+		return ((unsigned long)trailer[0] << 24) | ((unsigned long)trailer[1] << 16) |
+			((unsigned long)trailer[2] << 8) | (unsigned long)trailer[3];
+	}
+
+	// Inflates compressedData and checks it comes out exactly as data
+	int CompareInflated(	SavStreamCache &streams,
+							SavArena &arena,
+							const unsigned char *compressedData,
+							unsigned int compressedSize,
+							const unsigned char *data,
+							unsigned int size)
+	{
+		ezstream *stream = streams.AcquireInflate();
+		unsigned char *window = (unsigned char *)arena.Allocate(SAVPACKEDCACHE_WINDOWSIZE);
+		if (!stream || !window)
+		{
+			streams.ReleaseInflate(stream);
+			return ERR_MEMORY;
+		}
+
+		unsigned int compared = 0;
+		int errcode = ERR_NOTCACHED;
+		while (true)
+		{
+			long inLen = (long)compressedSize;
+			long outLen = SAVPACKEDCACHE_WINDOWSIZE;
+			int zcode = ezinflatestream(stream, window, &outLen, compressedData, &inLen);
+			compressedData += inLen;
+			compressedSize -= (unsigned int)inLen;
+
+			if (zcode < 0 || (unsigned int)outLen > size - compared ||
+				memcmp(window, data + compared, (size_t)outLen) != 0)
+			{
+				break;
+			}
+			compared += (unsigned int)outLen;
+			if (zcode == EZ_STREAM_END)
+			{
+				if (compared == size)
+					errcode = 0;
+				break;
+			}
+		}
+
+		streams.ReleaseInflate(stream);
+		return errcode;
+	}
+}
+
+SavPackedCache::Entry *SavPackedCache::FindEntry(const header_s *header)
+{
+	for (Entry &entry : entries)
+	{
+		if (entry.lastUsed != 0 &&
+			entry.header.hash == header->hash &&
+			entry.header.realSize == header->realSize &&
+			entry.header.compressedSize == header->compressedSize)
+		{
+			return &entry;
+		}
+	}
+	return 0;
+}
+
+void SavPackedCache::Remember(const header_s *header, const unsigned char *compressedData)
+{
+	//Anything shorter can't have a trailer
+	if (header->compressedSize < 2 + 4)
+		return;
+
+	Entry *entry = FindEntry(header);
+	if (entry)
+	{
+		//Already remembered
+		entry->lastUsed = ++useCount;
+		return;
+	}
+
+	Entry *slot = &entries[0];
+	for (Entry &other : entries)
+	{
+		if (other.lastUsed < slot->lastUsed)
+			slot = &other;
+	}
+
+	slot->lastUsed = 0;
+	try
+	{
+		slot->compressed.assign(compressedData, compressedData + header->compressedSize);
+	}
+	catch (const std::bad_alloc &)
+	{
+		//Only a missed shortcut; the save is compressed again if it is repacked
+		return;
+	}
+	slot->header = *header;
+	slot->adler = TrailerAdler(compressedData, header->compressedSize);
+	slot->lastUsed = ++useCount;
+}
+
+int SavPackedCache::Find(	SavStreamCache &streams,
+							SavArena &arena,
+							const unsigned char *data,
+							unsigned int size,
+							header_s *outHeader,
+							unsigned char **outCompressed)
+{
+	//Text of any other length can't match, so don't checksum it
+	bool sizeKnown = false;
+	for (const Entry &entry : entries)
+		sizeKnown = sizeKnown || (entry.lastUsed != 0 && entry.header.realSize == size);
+	if (!sizeKnown)
+		return ERR_NOTCACHED;
+
+	unsigned long adler = ezadler32(1, data, (long)size);
+	for (Entry &entry : entries)
+	{
+		if (entry.lastUsed == 0 || entry.header.realSize != size || entry.adler != adler)
+			continue;
+
+		int errcode = CompareInflated(streams, arena, entry.compressed.data(), entry.header.compressedSize, data, size);
+		if (errcode == ERR_NOTCACHED)
+			continue;
+		if (errcode)
+			return errcode;
+
+		errcode = Copy(&entry.header, arena, outCompressed);
+		if (!errcode)
+			*outHeader = entry.header;
+		return errcode;
+	}
+	return ERR_NOTCACHED;
+}
+
+int SavPackedCache::Copy(const header_s *header, SavArena &arena, unsigned char **outCompressed)
+{
+	Entry *entry = FindEntry(header);
+	if (!entry)
+		return ERR_NOTCACHED;
+
+	unsigned char *compressed = (unsigned char *)arena.Allocate(header->compressedSize);
+	if (!compressed)
+		return ERR_MEMORY;
+	memcpy(compressed, entry->compressed.data(), header->compressedSize);
+	entry->lastUsed = ++useCount;
+	*outCompressed = compressed;
+	return 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "SavFormat.h"
+
+#include <vector>
+
+class SavArena;
+class SavStreamCache;
+
+// How many saves a cache remembers; the least recently used is forgotten first
+#define SAVPACKEDCACHE_SIZE 4
+
+// The last few saves a SavContext or SavDocument unpacked or wrote: each one's header and compressed payload,
+// so that repacking text byte-for-byte identical to what one of them unpacked to can write the original bytes
+// back instead of compressing it all again. The text itself isn't kept here; zlib's trailer already holds
+// its Adler-32, which is the fingerprint, and a candidate is confirmed by inflating its payload.
+// Plain unpacks remember nothing. Like its owner, a cache is used by one call at a time.
+class SavPackedCache
+{
+public:
+	SavPackedCache() : useCount(0) {}
+
+	// Remembers a save that has just been unpacked without errors, or written. Out of memory, it just isn't.
+	void Remember(const header_s *header, const unsigned char *compressedData);
+
+	// Looks for a remembered save whose text is exactly data: the same size and Adler-32 first, then comparing it
+	// with the payload inflated a window at a time. On a hit, outHeader gets the save's header and *outCompressed
+	// a copy of its payload in arena. Returns 0 on a hit, ERR_NOTCACHED if no save matches, or ERR_MEMORY.
+	int Find(	SavStreamCache &streams,
+				SavArena &arena,
+				const unsigned char *data,
+				unsigned int size,
+				header_s *outHeader,
+				unsigned char **outCompressed);
+
+	// Copies the remembered payload of the save with this header into arena.
+	// Returns 0, ERR_NOTCACHED if the save isn't remembered, or ERR_MEMORY.
+	int Copy(const header_s *header, SavArena &arena, unsigned char **outCompressed);
+
+private:
+	struct Entry
+	{
+		Entry() : adler(0), lastUsed(0) {}
+
+		header_s header;
+		unsigned long adler; //Of the unpacked text, from the zlib trailer
+		unsigned long long lastUsed; //0 while the entry is empty
+		std::vector<unsigned char> compressed;
+	};
+
+	SavPackedCache(const SavPackedCache &);
+	SavPackedCache &operator=(const SavPackedCache &);
+
+	Entry *FindEntry(const header_s *header);
+
+	Entry entries[SAVPACKEDCACHE_SIZE];
+	unsigned long long useCount;
+};
@@ -0,0 +1,76 @@
+// SavPatch.cpp : Rewrites value attributes of unpacked save text without re-serializing it.
+//
+
+#include "SavPatch.h"
+#include "SavFormat.h"
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+int PatchText(	const char *text,
+				unsigned int size,
+				const SavValueSpan *spans,
+				const char *const *values,
+				unsigned int count,
+				char *outText,
+				unsigned int outCapacity,
+				unsigned int *outSize)
+{
+	//Apply edits in text order; among edits of the same span only the last one is kept
+	std::vector<unsigned int> order;
+	order.reserve(count);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		if (spans[i].offset == SAVPATH_NOTFOUND || spans[i].offset + spans[i].size > size)
+			return ERR_FORMAT;
+		order.push_back(i);
+	}
+	std::stable_sort(order.begin(), order.end(), [spans](unsigned int a, unsigned int b)
+	{
+		return spans[a].offset < spans[b].offset;
+	});
+
+	std::vector<size_t> valueSizes(count);
+	size_t patchedSize = size;
+	unsigned int previousEnd = 0;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		unsigned int edit = order[i];
+		if (i + 1 < order.size() && spans[order[i + 1]].offset == spans[edit].offset)
+		{
+			order[i] = SAVPATH_NOTFOUND;
+			continue;
+		}
+		if (spans[edit].offset < previousEnd)
+			return ERR_FORMAT;
+		previousEnd = spans[edit].offset + spans[edit].size;
+
+		valueSizes[edit] = strlen(values[edit]);
+		patchedSize += valueSizes[edit];
+		patchedSize -= spans[edit].size;
+	}
+
+	if (patchedSize > 0xFFFFFFFF)
+		return ERR_BUFFERSIZE;
+	*outSize = (unsigned int)patchedSize;
+	if (patchedSize > outCapacity)
+		return ERR_BUFFERSIZE;
+
+	unsigned int copied = 0;
+	char *out = outText;
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		unsigned int edit = order[i];
+		if (edit == SAVPATH_NOTFOUND)
+			continue;
+
+		memcpy(out, text + copied, spans[edit].offset - copied);
+		out += spans[edit].offset - copied;
+		memcpy(out, values[edit], valueSizes[edit]);
+		out += valueSizes[edit];
+		copied = spans[edit].offset + spans[edit].size;
+	}
+	memcpy(out, text + copied, size - copied);
+	return 0;
+}
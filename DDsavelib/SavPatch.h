@@ -0,0 +1,16 @@
+#pragma once
+
+#include "SavPath.h"
+
+// Copies text to outText, replacing the value attribute at spans[i] with values[i].
+// Untouched bytes are copied as they are. When two edits hit the same span the later one wins.
+// *outSize is set to the patched length; if that's more than outCapacity nothing is written and
+// ERR_BUFFERSIZE is returned. size plus the total length of the new values is always enough.
+int PatchText(	const char *text,
+				unsigned int size,
+				const SavValueSpan *spans,
+				const char *const *values,
+				unsigned int count,
+				char *outText,
+				unsigned int outCapacity,
+				unsigned int *outSize);
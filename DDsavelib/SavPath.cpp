@@ -0,0 +1,147 @@
+// SavPath.cpp : Finds elements of unpacked save text by path.
+//
+
+#include "SavPath.h"
+#include "SavFormat.h"
+
+#include <string.h>
+
+namespace
+{
+	//Elements nested deeper than this can't be matched; saves only go about a dozen levels deep
+	const unsigned int MaxDepth = 64;
+
+	bool ParseChildIndex(const char *segment, unsigned int size, int *outIndex)
+	{
+		if (size < 2 || segment[0] != '#')
+			return false;
+
+		int index = 0;
+		for (unsigned int i = 1; i < size; ++i)
+		{
+			if (segment[i] < '0' || segment[i] > '9')
+				return false;
+			index = index * 10 + (segment[i] - '0');
+		}
+		*outIndex = index;
+		return true;
+	}
+}
+
+SavPathMatcher::SavPathMatcher(const char *const *paths, unsigned int count)
+	: nextPath(count, -1)
+	, pathCount(count)
+{
+	Node root = { 0, 0, -1, -1, -1, -1 };
+	nodes.push_back(root);
+
+	for (unsigned int pathIndex = 0; pathIndex < count; ++pathIndex)
+	{
+		int node = 0;
+		const char *segment = paths[pathIndex];
+		while (true)
+		{
+			const char *segmentEnd = strchr(segment, '/');
+			unsigned int segmentSize = segmentEnd ? (unsigned int)(segmentEnd - segment) : (unsigned int)strlen(segment);
+
+			int childIndex = -1;
+			ParseChildIndex(segment, segmentSize, &childIndex);
+
+			int child = nodes[node].firstChild;
+			while (child >= 0 &&
+				!(nodes[child].childIndex == childIndex &&
+				nodes[child].segmentSize == segmentSize &&
+				memcmp(nodes[child].segment, segment, segmentSize) == 0))
+			{
+				child = nodes[child].nextSibling;
+			}
+			if (child < 0)
+			{
+				Node added = { segment, segmentSize, childIndex, -1, nodes[node].firstChild, -1 };
+				child = (int)nodes.size();
+				nodes.push_back(added);
+				nodes[node].firstChild = child;
+			}
+			node = child;
+
+			if (!segmentEnd)
+				break;
+			segment = segmentEnd + 1;
+		}
+
+		nextPath[pathIndex] = nodes[node].firstPath;
+		nodes[node].firstPath = (int)pathIndex;
+	}
+}
+
+int SavPathMatcher::FindChild(int node, const SavXmlSpan &name, unsigned int childIndex) const
+{
+	//A child by name goes before one by index, wherever they are among the candidates
+	int indexed = -1;
+	for (int child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling)
+	{
+		const Node &candidate = nodes[child];
+		if (candidate.childIndex >= 0)
+		{
+			if ((unsigned int)candidate.childIndex == childIndex)
+				indexed = child;
+		}
+		else if (candidate.segmentSize == name.size && memcmp(candidate.segment, name.data, name.size) == 0)
+		{
+			return child;
+		}
+	}
+	return indexed;
+}
+
+int SavPathMatcher::Resolve(const char *text, unsigned int size, SavValueSpan *outSpans) const
+{
+	for (unsigned int i = 0; i < pathCount; ++i)
+	{
+		outSpans[i].offset = SAVPATH_NOTFOUND;
+		outSpans[i].size = 0;
+	}
+
+	//Trie node of the open element at each depth (-1 when no path goes through it), and how many children it has had
+	int openNode[MaxDepth];
+	unsigned int childCount[MaxDepth];
+	//Each node matches only the first element it could, as a lookup by name in the tree does
+	std::vector<bool> matched(nodes.size());
+
+	SavXmlReader reader(text, size);
+	SavXmlEvent e;
+	while (true)
+	{
+		int errcode = reader.Next(&e);
+		if (errcode)
+			return errcode;
+		if (e.kind == SAVXML_EOF)
+			break;
+		if (e.kind != SAVXML_START || e.depth >= MaxDepth)
+			continue;
+
+		int node = 0;
+		if (e.depth > 0)
+		{
+			unsigned int childIndex = childCount[e.depth - 1]++;
+			int parent = openNode[e.depth - 1];
+			node = parent < 0 ? -1 : FindChild(parent, e.name, childIndex);
+			if (node >= 0 && matched[node])
+				node = -1;
+			else if (node >= 0)
+				matched[node] = true;
+		}
+		openNode[e.depth] = node;
+		childCount[e.depth] = 0;
+
+		if (node > 0 && e.value.data)
+		{
+			for (int path = nodes[node].firstPath; path >= 0; path = nextPath[path])
+			{
+				outSpans[path].offset = reader.OffsetOf(e.value);
+				outSpans[path].size = e.value.size;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "SavXml.h"
+
+#include <vector>
+
+// Finds elements by path in a single pass over unpacked text.
+// A path names elements below the root, separated by '/'. Each segment is either an element's
+// name attribute as written in the text (so &amp; stays escaped), or #N for the parent's Nth child
+// counting from 0, which is how unnamed array entries are reached. For example:
+//   mPlayerDataManual/mPlCmcEditAndParam/mCmc/#1/mEdit/(u8*)mNameStr/#0
+// As in PawnManager's SavPathTable, a child is matched by name before by index, and only the first element
+// a segment matches counts.
+class SavPathMatcher
+{
+public:
+	// The path strings must outlive the matcher
+	SavPathMatcher(const char *const *paths, unsigned int count);
+
+	// Fills outSpans[i] with the value attribute of the element at paths[i], or SAVPATH_NOTFOUND.
+	// Returns 0, or ERR_FORMAT if the text isn't well formed.
+	int Resolve(const char *text, unsigned int size, SavValueSpan *outSpans) const;
+
+private:
+	struct Node
+	{
+		const char *segment;
+		unsigned int segmentSize;
+		int childIndex; //-1 for a name segment
+		int firstChild;
+		int nextSibling;
+		int firstPath; //First path ending at this node, -1 if none
+	};
+
+	int FindChild(int node, const SavXmlSpan &name, unsigned int childIndex) const;
+
+	std::vector<Node> nodes;
+	std::vector<int> nextPath; //Further paths ending at the same node, for duplicates
+	unsigned int pathCount;
+};
@@ -0,0 +1,105 @@
+// SavPawn.cpp : Reads one pawn's parameters out of unpacked save text.
+//
+
+#include "SavPawn.h"
+#include "SavFormat.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+	//Longer than any number a save writes
+	const unsigned int ValueMaxSize = 64;
+
+	// Parses a value attribute the way the managed side always has: as an integer, or failing that as a
+	// float with its fraction dropped. Returns false if it is neither.
+	bool ParseValue(const char *text, const SavValueSpan &span, long long *outValue)
+	{
+		if (span.size == 0 || span.size >= ValueMaxSize)
+			return false;
+		char value[ValueMaxSize];
+		memcpy(value, text + span.offset, span.size);
+		value[span.size] = 0;
+
+		char *end = 0;
+		long long integer = strtoll(value, &end, 10);
+		if (*end == 0)
+		{
+			*outValue = integer;
+			return true;
+		}
+		float real = strtof(value, &end);
+		if (*end != 0)
+			return false;
+		*outValue = (long long)real;
+		return true;
+	}
+}
+
+void SavPawnConfig::Add(unsigned int slot, const char *path, int flags)
+{
+	Slot &table = slots[slot];
+	Entry entry = { flags, (unsigned int)table.paths.size() };
+	table.entries.push_back(entry);
+	if (flags & SAVPAWN_WRITEONLY)
+		return;
+
+	if (!(flags & SAVPAWN_NAME))
+	{
+		table.paths.push_back(path);
+		return;
+	}
+	for (unsigned int i = 0; i < SAVPAWN_NAMELENGTH; ++i)
+		table.paths.push_back(std::string(path) + "/#" + std::to_string(i));
+}
+
+void SavPawnConfig::GetPaths(unsigned int slot, std::vector<const char *> *outPaths) const
+{
+	const Slot &table = slots[slot];
+	outPaths->clear();
+	outPaths->reserve(table.paths.size());
+	for (size_t i = 0; i < table.paths.size(); ++i)
+		outPaths->push_back(table.paths[i].c_str());
+}
+
+int SavPawnConfig::Read(	unsigned int slot,
+							const char *text,
+							const SavValueSpan *spans,
+							SavPawnValue *outValues,
+							unsigned int capacity,
+							unsigned int *outCount) const
+{
+	const Slot &table = slots[slot];
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < table.entries.size(); ++i)
+	{
+		const Entry &entry = table.entries[i];
+		if (entry.flags & SAVPAWN_WRITEONLY)
+			continue;
+
+		//A name ends at its first 0 letter, or its first missing one
+		unsigned int letterCount = entry.flags & SAVPAWN_NAME ? SAVPAWN_NAMELENGTH : 1;
+		for (unsigned int j = 0; j < letterCount; ++j)
+		{
+			const SavValueSpan &span = spans[entry.firstPath + j];
+			if (span.offset == SAVPATH_NOTFOUND)
+				break;
+
+			long long value = 0;
+			if (!ParseValue(text, span, &value))
+				return ERR_FORMAT;
+			if ((entry.flags & SAVPAWN_NAME) && value == 0)
+				break;
+			if (count == capacity)
+				return ERR_BUFFERSIZE;
+
+			outValues[count].entry = i;
+			outValues[count].value = value;
+			++count;
+		}
+	}
+
+	*outCount = count;
+	return 0;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "DDsavelib.h"
+
+#include <string>
+#include <vector>
+
+// The elements of a save holding one pawn's parameters, for each of the slots a pawn can be in, as the
+// sav section of config.xml compiles to. Each slot's entries are looked up with one SavPathMatcher pass,
+// and only their values are handed back, parsed into integers.
+struct SavPawnConfig
+{
+	// Adds an entry to slot, which is in range. A name's letters are looked up as path/#0 and on.
+	void Add(unsigned int slot, const char *path, int flags);
+
+	// The paths of the elements slot's readable entries need, each name expanded into its letters.
+	// They point into the config, and stay valid until the next Add.
+	void GetPaths(unsigned int slot, std::vector<const char *> *outPaths) const;
+
+	// Turns the spans of GetPaths's elements in text into slot's values, as ExtractPawn gives them.
+	// Returns 0, ERR_BUFFERSIZE if there are more than capacity, or ERR_FORMAT if one isn't a number.
+	int Read(	unsigned int slot,
+				const char *text,
+				const SavValueSpan *spans,
+				SavPawnValue *outValues,
+				unsigned int capacity,
+				unsigned int *outCount) const;
+
+private:
+	struct Entry
+	{
+		int flags;
+		unsigned int firstPath; //Index into the slot's paths; write-only entries have none
+	};
+
+	struct Slot
+	{
+		std::vector<Entry> entries;
+		std::vector<std::string> paths;
+	};
+
+	Slot slots[SAVPAWN_SLOTCOUNT];
+};
@@ -0,0 +1,149 @@
+// SavThreadPool.cpp : Work-stealing worker threads.
+//
+
+#include "SavThreadPool.h"
+
+SavThreadPool::SavThreadPool(unsigned int threadCount)
+	: threadCount(threadCount), task(0), generation(0), busy(0), stopping(false)
+{
+	if (this->threadCount == 0)
+		this->threadCount = std::thread::hardware_concurrency();
+	if (this->threadCount == 0)
+		this->threadCount = 1;
+
+	shares.reset(new Share[this->threadCount]);
+	for (unsigned int i = 0; i < this->threadCount; ++i)
+	{
+		shares[i].next = 0;
+		shares[i].end = 0;
+	}
+
+	//The thread calling For is worker 0
+	try
+	{
+		workers.reserve(this->threadCount - 1);
+		for (unsigned int i = 1; i < this->threadCount; ++i)
+			workers.push_back(std::thread(&SavThreadPool::WorkerLoop, this, i));
+	}
+	catch (...)
+	{
+		//The destructor won't run, and a joinable thread left behind would terminate the process
+		Stop();
+		throw;
+	}
+}
+
+SavThreadPool::~SavThreadPool()
+{
+	Stop();
+}
+
+void SavThreadPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread &worker : workers)
+		worker.join();
+}
+
+void SavThreadPool::For(unsigned int count, const std::function<void(unsigned int)> &task)
+{
+	if (count == 0)
+		return;
+	std::lock_guard<std::mutex> running(forLock);
+
+	//Contiguous shares, so neighbouring tasks stay on one thread until someone steals
+	for (unsigned int i = 0; i < threadCount; ++i)
+	{
+		std::lock_guard<std::mutex> guard(shares[i].lock);
+		shares[i].next = (unsigned int)((unsigned long long)count * i / threadCount);
+		shares[i].end = (unsigned int)((unsigned long long)count * (i + 1) / threadCount);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		this->task = &task;
+		++generation;
+		busy = (unsigned int)workers.size();
+	}
+	wake.notify_all();
+
+	Work(0);
+
+	std::unique_lock<std::mutex> guard(lock);
+	done.wait(guard, [this]() { return busy == 0; });
+	this->task = 0;
+}
+
+void SavThreadPool::WorkerLoop(unsigned int self)
+{
+	unsigned int seen = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this, seen]() { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+		}
+
+		Work(self);
+
+		std::lock_guard<std::mutex> guard(lock);
+		if (--busy == 0)
+			done.notify_all();
+	}
+}
+
+void SavThreadPool::Work(unsigned int self)
+{
+	unsigned int index;
+	while (true)
+	{
+		if (Pop(self, &index))
+			(*task)(index);
+		else if (!Steal(self))
+			return;
+	}
+}
+
+bool SavThreadPool::Pop(unsigned int self, unsigned int *outIndex)
+{
+	Share &share = shares[self];
+	std::lock_guard<std::mutex> guard(share.lock);
+	if (share.next >= share.end)
+		return false;
+	*outIndex = share.next++;
+	return true;
+}
+
+bool SavThreadPool::Steal(unsigned int self)
+{
+	for (unsigned int i = 1; i < threadCount; ++i)
+	{
+		Share &victim = shares[(self + i) % threadCount];
+		unsigned int first;
+		unsigned int end;
+		{
+			std::lock_guard<std::mutex> guard(victim.lock);
+			if (victim.next >= victim.end)
+				continue;
+			//Take the back half, leaving the victim the tasks it is about to start
+			unsigned int left = victim.end - victim.next;
+			end = victim.end;
+			first = end - (left + 1) / 2;
+			victim.end = first;
+		}
+
+		Share &share = shares[self];
+		std::lock_guard<std::mutex> guard(share.lock);
+		share.next = first;
+		share.end = end;
+		return true;
+	}
+	return false;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker threads for running many independent tasks at once, like one per save in a batch.
+// Each thread starts on its own share of the task indices and works through it in order; a thread
+// that runs out steals the back half of another thread's share, so a few slow tasks don't leave
+// the other threads idle while work is waiting.
+class SavThreadPool
+{
+public:
+	// threadCount counts the thread calling For, so 1 runs everything on the caller;
+	// 0 picks one thread per core. Throws std::system_error if a thread can't be started.
+	explicit SavThreadPool(unsigned int threadCount);
+	~SavThreadPool();
+
+	unsigned int GetThreadCount() const { return threadCount; }
+
+	// Runs task(i) for every i below count, returning once all of them have finished.
+	// Tasks run on several threads at once, and must not throw.
+	void For(unsigned int count, const std::function<void(unsigned int)> &task);
+
+private:
+	//Task indices [next, end) waiting on one thread
+	struct Share
+	{
+		std::mutex lock;
+		unsigned int next;
+		unsigned int end;
+	};
+
+	SavThreadPool(const SavThreadPool &);
+	SavThreadPool &operator=(const SavThreadPool &);
+
+	void Stop(); //Ends and joins the workers
+	void WorkerLoop(unsigned int self);
+	void Work(unsigned int self);
+	bool Pop(unsigned int self, unsigned int *outIndex);
+	bool Steal(unsigned int self);
+
+	unsigned int threadCount;
+	std::unique_ptr<Share[]> shares;
+	std::vector<std::thread> workers;
+
+	std::mutex forLock; //Only one For runs at a time
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(unsigned int)> *task;
+	unsigned int generation; //Bumped for every For, so workers can tell a new one has started
+	unsigned int busy; //Workers still working on the current For
+	bool stopping;
+};
@@ -0,0 +1,219 @@
+// SavXml.cpp : Pull parser for unpacked save text.
+//
+
+#include "SavXml.h"
+#include "SavFormat.h"
+
+#include <string.h>
+
+namespace
+{
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+
+	inline const char *SkipSpace(const char *p, const char *end)
+	{
+		while (p < end && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	inline const char *SkipName(const char *p, const char *end)
+	{
+		while (p < end && !IsSpace(*p) && *p != '=' && *p != '/' && *p != '>')
+			++p;
+		return p;
+	}
+
+	inline SavXmlSpan MakeSpan(const char *begin, const char *end)
+	{
+		SavXmlSpan span = { begin, (unsigned int)(end - begin) };
+		return span;
+	}
+
+	const SavXmlSpan EmptySpan = { 0, 0 };
+
+	unsigned int ParseCount(const SavXmlSpan &span)
+	{
+		unsigned int count = 0;
+		for (unsigned int i = 0; i < span.size && span.data[i] >= '0' && span.data[i] <= '9'; ++i)
+		{
+			count = count * 10 + (span.data[i] - '0');
+		}
+		return count;
+	}
+}
+
+bool SpanEquals(const SavXmlSpan &span, const char *str)
+{
+	size_t length = strlen(str);
+	return span.size == length && memcmp(span.data, str, length) == 0;
+}
+
+SavXmlReader::SavXmlReader(const char *text, unsigned int size)
+	: text(text)
+	, pos(text)
+	, end(text + size)
+	, depth(0)
+	, finished(false)
+	, sawRoot(false)
+	, pendingEnd(false)
+{
+}
+
+int SavXmlReader::Next(SavXmlEvent *outEvent)
+{
+	if (pendingEnd)
+	{
+		pendingEnd = false;
+		*outEvent = pendingEvent;
+		if (outEvent->depth == 0)
+			finished = true;
+		return 0;
+	}
+
+	while (!finished)
+	{
+		const char *tagStart = (const char *)memchr(pos, '<', end - pos);
+		if (!tagStart || tagStart + 1 >= end)
+			break;
+
+		char marker = tagStart[1];
+		if (marker == '/')
+		{
+			return ReadEndTag(tagStart, outEvent);
+		}
+		else if (marker == '?' || marker == '!')
+		{
+			//Prolog, comment or doctype: skip to the closing '>'
+			const char *close = (const char *)memchr(tagStart, '>', end - tagStart);
+			if (!close)
+				return ERR_FORMAT;
+			pos = close + 1;
+		}
+		else
+		{
+			return ReadStartTag(tagStart, outEvent);
+		}
+	}
+
+	//Only whitespace may follow the root element, and there must have been one
+	if (!sawRoot || SkipSpace(pos, end) != end || depth != 0)
+		return ERR_FORMAT;
+
+	memset(outEvent, 0, sizeof(SavXmlEvent));
+	outEvent->kind = SAVXML_EOF;
+	finished = true;
+	return 0;
+}
+
+int SavXmlReader::ReadStartTag(const char *tagStart, SavXmlEvent *outEvent)
+{
+	const char *p = tagStart + 1;
+	const char *tagEnd = SkipName(p, end);
+	if (tagEnd == p)
+		return ERR_FORMAT;
+
+	outEvent->kind = SAVXML_START;
+	outEvent->isEmpty = 0;
+	outEvent->depth = depth;
+	outEvent->offset = (unsigned int)(tagStart - text);
+	outEvent->count = 0;
+	outEvent->tag = MakeSpan(p, tagEnd);
+	outEvent->name = EmptySpan;
+	outEvent->type = EmptySpan;
+	outEvent->value = EmptySpan;
+
+	p = SkipSpace(tagEnd, end);
+	const char *attributesStart = p;
+	const char *attributesEnd = p;
+	while (p < end && *p != '>' && *p != '/')
+	{
+		const char *attrName = p;
+		const char *attrNameEnd = SkipName(p, end);
+		p = SkipSpace(attrNameEnd, end);
+		if (attrNameEnd == attrName || p >= end || *p != '=')
+			return ERR_FORMAT;
+		p = SkipSpace(p + 1, end);
+		if (p >= end || (*p != '"' && *p != '\''))
+			return ERR_FORMAT;
+
+		const char *valueStart = p + 1;
+		const char *valueEnd = (const char *)memchr(valueStart, *p, end - valueStart);
+		if (!valueEnd)
+			return ERR_FORMAT;
+
+		SavXmlSpan attrNameSpan = MakeSpan(attrName, attrNameEnd);
+		SavXmlSpan attrValue = MakeSpan(valueStart, valueEnd);
+		if (SpanEquals(attrNameSpan, "name"))
+			outEvent->name = attrValue;
+		else if (SpanEquals(attrNameSpan, "value"))
+			outEvent->value = attrValue;
+		else if (SpanEquals(attrNameSpan, "type"))
+			outEvent->type = attrValue;
+		else if (SpanEquals(attrNameSpan, "count"))
+			outEvent->count = ParseCount(attrValue);
+
+		attributesEnd = valueEnd + 1;
+		p = SkipSpace(attributesEnd, end);
+	}
+	outEvent->attributes = MakeSpan(attributesStart, attributesEnd);
+
+	if (p < end && *p == '/')
+	{
+		++p;
+		if (p >= end || *p != '>')
+			return ERR_FORMAT;
+		outEvent->isEmpty = 1;
+	}
+	if (p >= end)
+		return ERR_FORMAT;
+
+	pos = p + 1;
+	outEvent->size = (unsigned int)(pos - tagStart);
+
+	if (outEvent->isEmpty)
+	{
+		pendingEnd = true;
+		pendingEvent = *outEvent;
+		pendingEvent.kind = SAVXML_END;
+		pendingEvent.attributes = EmptySpan;
+	}
+	else
+	{
+		if (depth >= SAVXML_MAXDEPTH)
+			return ERR_FORMAT;
+		openTags[depth] = outEvent->tag;
+		++depth;
+	}
+	sawRoot = true;
+	return 0;
+}
+
+int SavXmlReader::ReadEndTag(const char *tagStart, SavXmlEvent *outEvent)
+{
+	const char *p = tagStart + 2;
+	const char *tagEnd = SkipName(p, end);
+	const char *close = SkipSpace(tagEnd, end);
+	if (tagEnd == p || close >= end || *close != '>' || depth == 0)
+		return ERR_FORMAT;
+
+	const SavXmlSpan &openTag = openTags[depth - 1];
+	if (openTag.size != (unsigned int)(tagEnd - p) || memcmp(openTag.data, p, openTag.size) != 0)
+		return ERR_FORMAT;
+
+	--depth;
+	memset(outEvent, 0, sizeof(SavXmlEvent));
+	outEvent->kind = SAVXML_END;
+	outEvent->depth = depth;
+	outEvent->offset = (unsigned int)(tagStart - text);
+	outEvent->tag = MakeSpan(p, tagEnd);
+
+	pos = close + 1;
+	outEvent->size = (unsigned int)(pos - tagStart);
+	if (depth == 0)
+		finished = true;
+	return 0;
+}
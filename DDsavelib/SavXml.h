@@ -0,0 +1,43 @@
+#pragma once
+
+#include "DDsavelib.h"
+
+// Pull parser for the restricted XML dialect of unpacked saves: a prolog, then nested elements
+// whose only content is other elements, with double- or single-quoted attributes.
+// It never allocates or copies; every span in an event points into the text it was given.
+
+// Deepest nesting the reader follows; saves go about a dozen levels deep
+#define SAVXML_MAXDEPTH 64
+
+struct SavXmlReader
+{
+	SavXmlReader(const char *text, unsigned int size);
+
+	// Fills outEvent with the next element boundary. Returns 0, or ERR_FORMAT if the text isn't well formed:
+	// an end tag that doesn't match the open element, no root element, or nesting deeper than SAVXML_MAXDEPTH.
+	int Next(SavXmlEvent *outEvent);
+
+	// Byte offset of a span inside the text
+	unsigned int OffsetOf(const SavXmlSpan &span) const { return (unsigned int)(span.data - text); }
+
+private:
+	int ReadStartTag(const char *tagStart, SavXmlEvent *outEvent);
+	int ReadEndTag(const char *tagStart, SavXmlEvent *outEvent);
+
+	const char *text;
+	const char *pos;
+	const char *end;
+	unsigned int depth;
+	bool finished;
+	bool sawRoot;
+
+	//Tag names of the open elements, outermost first
+	SavXmlSpan openTags[SAVXML_MAXDEPTH];
+
+	//A self-closing element's END is given on the call after its START
+	bool pendingEnd;
+	SavXmlEvent pendingEvent;
+};
+
+// True if span holds exactly the null-terminated string str
+bool SpanEquals(const SavXmlSpan &span, const char *str);
@@ -8067,3 +8067,199 @@ int ezuncompress( unsigned char* pDest, long* pnDestLen, const unsigned char* pS
     return nExtraChunks ? Z_BUF_ERROR : Z_OK;
 }
 
+/* easy zlib streaming functions
+*/
+struct ezstream
+{
+    z_stream stream;
+};
+
+/* the ezstream comes from the same allocator as zlib's state, malloc when none is given */
+local ezstream* ezallocstream( ezallocfunc pfnAlloc, ezfreefunc pfnFree, void* pOpaque )
+{
+    ezstream* pStream = pfnAlloc ? (ezstream*)pfnAlloc(pOpaque, 1, sizeof(ezstream)) : (ezstream*)malloc(sizeof(ezstream));
+    if (pStream == Z_NULL) return Z_NULL;
+
+    pStream->stream.next_in = Z_NULL;
+    pStream->stream.avail_in = 0;
+    pStream->stream.zalloc = (alloc_func)pfnAlloc;
+    pStream->stream.zfree = (free_func)pfnFree;
+    pStream->stream.opaque = (voidpf)pOpaque;
+    return pStream;
+}
+
+/* once a stream is initialized zfree is set, to zlib's own free if no allocator was given */
+local void ezfreestream( ezstream* pStream, free_func pfnFree, voidpf pOpaque )
+{
+    if (pfnFree) pfnFree(pOpaque, pStream);
+    else free(pStream);
+}
+
+ezstream* ezinflateopen2( ezallocfunc pfnAlloc, ezfreefunc pfnFree, void* pOpaque )
+{
+    ezstream* pStream = ezallocstream(pfnAlloc, pfnFree, pOpaque);
+    if (pStream == Z_NULL) return Z_NULL;
+
+    if (inflateInit(&pStream->stream) != Z_OK) {
+        ezfreestream(pStream, (free_func)pfnFree, pOpaque);
+        return Z_NULL;
+    }
+    return pStream;
+}
+
+int ezinflatestream( ezstream* pStream, unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long* pnSrcLen )
+{
+    z_stream* stream = &pStream->stream;
+    int err;
+
+    stream->next_in = (Bytef*)pSrc;
+    stream->avail_in = (uInt)*pnSrcLen;
+    stream->next_out = pDest;
+    stream->avail_out = (uInt)*pnDestLen;
+
+    err = inflate(stream, Z_NO_FLUSH);
+    if (err == Z_NEED_DICT)
+        err = Z_DATA_ERROR;
+
+    *pnSrcLen -= (long)stream->avail_in;
+    *pnDestLen -= (long)stream->avail_out;
+    return err;
+}
+
+void ezinflateclose( ezstream* pStream )
+{
+    free_func pfnFree;
+    voidpf pOpaque;
+    if (pStream == Z_NULL) return;
+    pfnFree = pStream->stream.zfree;
+    pOpaque = pStream->stream.opaque;
+    inflateEnd(&pStream->stream);
+    ezfreestream(pStream, pfnFree, pOpaque);
+}
+
+int ezdeflatestream( ezstream* pStream, unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long* pnSrcLen, int nFlush )
+{
+    z_stream* stream = &pStream->stream;
+    int err;
+
+    stream->next_in = (Bytef*)pSrc;
+    stream->avail_in = (uInt)*pnSrcLen;
+    stream->next_out = pDest;
+    stream->avail_out = (uInt)*pnDestLen;
+
+    err = deflate(stream, nFlush);
+
+    *pnSrcLen -= (long)stream->avail_in;
+    *pnDestLen -= (long)stream->avail_out;
+    return err;
+}
+
+void ezdeflateclose( ezstream* pStream )
+{
+    free_func pfnFree;
+    voidpf pOpaque;
+    if (pStream == Z_NULL) return;
+    pfnFree = pStream->stream.zfree;
+    pOpaque = pStream->stream.opaque;
+    deflateEnd(&pStream->stream);
+    ezfreestream(pStream, pfnFree, pOpaque);
+}
+
+ezstream* ezrawdeflateopen2( int nLevel, int nStrategy, ezallocfunc pfnAlloc, ezfreefunc pfnFree, void* pOpaque )
+{
+    ezstream* pStream = ezallocstream(pfnAlloc, pfnFree, pOpaque);
+    if (pStream == Z_NULL) return Z_NULL;
+
+    /* negative window bits ask for raw deflate */
+    if (deflateInit2(&pStream->stream, nLevel, Z_DEFLATED, -MAX_WBITS, DEF_MEM_LEVEL, nStrategy) != Z_OK) {
+        ezfreestream(pStream, (free_func)pfnFree, pOpaque);
+        return Z_NULL;
+    }
+    return pStream;
+}
+
+int ezdeflatedictionary( ezstream* pStream, const unsigned char* pDict, long nDictLen )
+{
+    return deflateSetDictionary(&pStream->stream, (const Bytef*)pDict, (uInt)nDictLen);
+}
+
+int ezinflatereset( ezstream* pStream )
+{
+    return inflateReset(&pStream->stream);
+}
+
+int ezdeflatereset( ezstream* pStream, int nLevel, int nStrategy )
+{
+    int err = deflateReset(&pStream->stream);
+    if (err != Z_OK) return err;
+    /* nothing has been compressed since the reset, so this only swaps settings */
+    return deflateParams(&pStream->stream, nLevel, nStrategy);
+}
+
+ezstream* ezrawinflateopen2( ezallocfunc pfnAlloc, ezfreefunc pfnFree, void* pOpaque )
+{
+    ezstream* pStream = ezallocstream(pfnAlloc, pfnFree, pOpaque);
+    if (pStream == Z_NULL) return Z_NULL;
+
+    /* negative window bits ask for raw inflate */
+    if (inflateInit2(&pStream->stream, -MAX_WBITS) != Z_OK) {
+        ezfreestream(pStream, (free_func)pfnFree, pOpaque);
+        return Z_NULL;
+    }
+    return pStream;
+}
+
+int ezinflateblock( ezstream* pStream, unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long* pnSrcLen, int* pnBits )
+{
+    z_stream* stream = &pStream->stream;
+    int err;
+
+    stream->next_in = (Bytef*)pSrc;
+    stream->avail_in = (uInt)*pnSrcLen;
+    stream->next_out = pDest;
+    stream->avail_out = (uInt)*pnDestLen;
+
+    err = inflate(stream, Z_BLOCK);
+    if (err == Z_NEED_DICT)
+        err = Z_DATA_ERROR;
+
+    /* bit 7 of data_type is set at a block boundary, bit 6 once the final block is done */
+    if ((stream->data_type & 128) && !(stream->data_type & 64))
+        *pnBits = stream->data_type & 7;
+    else
+        *pnBits = -1;
+
+    *pnSrcLen -= (long)stream->avail_in;
+    *pnDestLen -= (long)stream->avail_out;
+    return err;
+}
+
+int ezinflateprime( ezstream* pStream, int nBits, int nValue )
+{
+    return inflatePrime(&pStream->stream, nBits, nValue);
+}
+
+int ezinflatedictionary( ezstream* pStream, const unsigned char* pDict, long nDictLen )
+{
+    return inflateSetDictionary(&pStream->stream, (const Bytef*)pDict, (uInt)nDictLen);
+}
+
+unsigned long ezinflateadler( ezstream* pStream )
+{
+    return (unsigned long)pStream->stream.adler;
+}
+
+int ezdeflateprime( ezstream* pStream, int nBits, int nValue )
+{
+    return deflatePrime(&pStream->stream, nBits, nValue);
+}
+
+unsigned long ezadler32( unsigned long nAdler, const unsigned char* pSrc, long nSrcLen )
+{
+    return adler32((uLong)nAdler, (const Bytef*)pSrc, (uInt)nSrcLen);
+}
+
+unsigned long ezadler32combine( unsigned long nAdler1, unsigned long nAdler2, long nLen2 )
+{
+    return adler32_combine((uLong)nAdler1, (uLong)nAdler2, (z_off_t)nLen2);
+}
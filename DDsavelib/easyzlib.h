@@ -12,11 +12,25 @@
 #define _EASYZLIB_H
 
 /* Return codes */
+#define EZ_STREAM_END    1
 #define EZ_STREAM_ERROR  (-2)
 #define EZ_DATA_ERROR    (-3)
 #define EZ_MEM_ERROR     (-4)
 #define EZ_BUF_ERROR     (-5)
 
+/* Compression levels */
+#define EZ_DEFAULT_COMPRESSION (-1)
+
+/* Compression strategies */
+#define EZ_DEFAULT_STRATEGY 0
+
+/* Flush values for ezdeflatestream */
+#define EZ_SYNC_FLUSH    2
+#define EZ_FINISH        4
+
+/* Largest preset dictionary deflate can use, the size of its window */
+#define EZ_DICTIONARYSIZE 32768
+
 /* Calculate maximum compressed length from uncompressed length */
 #define EZ_COMPRESSMAXDESTLENGTH(n) (n+(((n)/1000)+1)+12)
 
@@ -28,6 +42,57 @@ extern "C"
 int ezcompress( unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long nSrcLen );
 int ezuncompress( unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long nSrcLen );
 
+/* Streaming functions
+   An ezstream keeps a z_stream alive so data can be processed a piece at a time.
+   On return *pnSrcLen and *pnDestLen are set to the bytes consumed and produced.
+   Returns EZ_STREAM_END once the stream is complete, or EZ_BUF_ERROR if no progress
+   was possible (more input or more output space is needed) */
+typedef struct ezstream ezstream;
+
+int ezinflatestream( ezstream* pStream, unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long* pnSrcLen );
+void ezinflateclose( ezstream* pStream );
+
+int ezdeflatestream( ezstream* pStream, unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long* pnSrcLen, int nFlush );
+void ezdeflateclose( ezstream* pStream );
+
+/* Opens a zlib inflate stream, or a raw deflate stream, without the zlib header and Adler-32 trailer,
+   so independently compressed pieces ended with EZ_SYNC_FLUSH can be joined into one stream.
+   The stream and all of zlib's memory for it come from pfnAlloc and go back to pfnFree, called
+   with pOpaque the way zlib calls zalloc and zfree. ezdeflatedictionary primes a deflate stream
+   with the data that comes before its piece, and must be called before any input. */
+typedef void* (*ezallocfunc)( void* pOpaque, unsigned int nItems, unsigned int nSize );
+typedef void (*ezfreefunc)( void* pOpaque, void* pAddress );
+ezstream* ezinflateopen2( ezallocfunc pfnAlloc, ezfreefunc pfnFree, void* pOpaque );
+ezstream* ezrawdeflateopen2( int nLevel, int nStrategy, ezallocfunc pfnAlloc, ezfreefunc pfnFree, void* pOpaque );
+int ezdeflatedictionary( ezstream* pStream, const unsigned char* pDict, long nDictLen );
+
+/* Returns a stream to the state it was opened in, keeping its memory for the next stream.
+   ezdeflatereset also switches to nLevel and nStrategy, and works on raw streams as well. */
+int ezinflatereset( ezstream* pStream );
+int ezdeflatereset( ezstream* pStream, int nLevel, int nStrategy );
+
+/* Random access into a deflate stream, as in zlib's zran example. ezinflateblock is ezinflatestream
+   stopping at the end of each deflate block: *pnBits gets how many bits of the last byte consumed
+   belong to the next block, or -1 if it stopped anywhere else, including after the final block.
+   A raw inflate stream resumes at such a boundary once ezinflateprime has fed it those bits and
+   ezinflatedictionary the text before the boundary, both before any input. */
+ezstream* ezrawinflateopen2( ezallocfunc pfnAlloc, ezfreefunc pfnFree, void* pOpaque );
+int ezinflateblock( ezstream* pStream, unsigned char* pDest, long* pnDestLen, const unsigned char* pSrc, long* pnSrcLen, int* pnBits );
+int ezinflateprime( ezstream* pStream, int nBits, int nValue );
+int ezinflatedictionary( ezstream* pStream, const unsigned char* pDict, long nDictLen );
+
+/* Adler-32 of everything a zlib inflate stream has output so far */
+unsigned long ezinflateadler( ezstream* pStream );
+
+/* Starts a deflate stream's output with the low nBits bits of nValue, so it can carry on from a
+   boundary inside the last byte of earlier output. Must be called before any input. */
+int ezdeflateprime( ezstream* pStream, int nBits, int nValue );
+
+/* Adler-32 of the data, continuing from nAdler (1 to start). ezadler32combine gives the
+   Adler-32 of two pieces joined, from each one's and the length of the second. */
+unsigned long ezadler32( unsigned long nAdler, const unsigned char* pSrc, long nSrcLen );
+unsigned long ezadler32combine( unsigned long nAdler1, unsigned long nAdler2, long nLen2 );
+
 #ifdef __cplusplus
 }
 
@@ -47,7 +112,7 @@ private:
 
 #define EZ_CHECKLENGTH 8192
 
-int ezcompress( ezbuffer& bufDest, const ezbuffer& bufSrc )
+inline int ezcompress( ezbuffer& bufDest, const ezbuffer& bufSrc )
 {
 	if ( bufDest.nLen == 0 )
 		bufDest.Alloc( EZ_CHECKLENGTH );
@@ -60,7 +125,7 @@ int ezcompress( ezbuffer& bufDest, const ezbuffer& bufSrc )
 	return nErr;
 };
 
-int ezuncompress( ezbuffer& bufDest, const ezbuffer& bufSrc )
+inline int ezuncompress( ezbuffer& bufDest, const ezbuffer& bufSrc )
 {
 	if ( bufDest.nLen == 0 )
 		bufDest.Alloc( EZ_CHECKLENGTH );
@@ -76,7 +141,7 @@ int ezuncompress( ezbuffer& bufDest, const ezbuffer& bufSrc )
 #ifdef MCD_STR
 /* CMarkup designated string class and macros */
 
-int ezcompress( ezbuffer& bufDest, const MCD_STR& strSrc )
+inline int ezcompress( ezbuffer& bufDest, const MCD_STR& strSrc )
 {
 	int nSrcLen = MCD_STRLENGTH(strSrc) * sizeof(MCD_CHAR);
 	/* alternatively: bufDest.Alloc( EZ_COMPRESSMAXDESTLENGTH(nSrcLen) ); // >.1% + 12 */
@@ -88,7 +153,7 @@ int ezcompress( ezbuffer& bufDest, const MCD_STR& strSrc )
 	return nErr;
 }
 
-int ezuncompress( MCD_STR& strDest, const ezbuffer& bufSrc )
+inline int ezuncompress( MCD_STR& strDest, const ezbuffer& bufSrc )
 {
 	unsigned char pTempDest[EZ_CHECKLENGTH];
 	long nTempLen = EZ_CHECKLENGTH;
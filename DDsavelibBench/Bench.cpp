@@ -0,0 +1,497 @@
+// Bench.cpp : Times DDsavelib's Unpack, Repack and Validate and prints the results as JSON.
+//
+// Usage: DDsavelibBench [--sample path] [--sizes 1,2,4] [--iterations n] [--workdir dir] [--out file]
+//                       [--batch n] [--threads n]
+//
+// The corpus is the sample save (test/input.sav by default) plus synthetic saves of each size in MB.
+// The repack stage compresses the whole text with Repack; repackUnchanged repacks it on a SavContext that has
+// just written it, which only writes the same bytes back.
+// Repack refuses saves that don't fit in a save slot; those report error 9 for repack and are written
+// without the slot's limit instead, so the other stages still measure them.
+// DDsavelib is compiled into this executable rather than loaded as a DLL, so the operator new
+// counters below see its allocations too; zlib's own mallocs are not counted.
+
+#include "Crc32.h"
+#include "DDsavelib.h"
+#include "SavFormat.h"
+#include "SyntheticSave.h"
+#include "easyzlib.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <psapi.h>
+#include <direct.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	//Allocations through operator new, for the stage being measured
+	std::atomic<unsigned long long> allocationCount(0);
+	std::atomic<unsigned long long> allocatedBytes(0);
+	std::atomic<long long> liveBytes(0);
+	std::atomic<long long> peakLiveBytes(0);
+
+	//Each block is prefixed with its size so delete can account for it
+	const size_t AllocationHeader = 16;
+
+	void *CountedAlloc(size_t size)
+	{
+		void *block = malloc(size + AllocationHeader);
+		if (!block)
+			throw std::bad_alloc();
+		*(size_t *)block = size;
+
+		allocationCount += 1;
+		allocatedBytes += size;
+		long long live = liveBytes += (long long)size;
+		long long peak = peakLiveBytes;
+		while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live))
+		{
+		}
+		return (char *)block + AllocationHeader;
+	}
+
+	void CountedFree(void *pointer)
+	{
+		if (!pointer)
+			return;
+		void *block = (char *)pointer - AllocationHeader;
+		liveBytes -= (long long)*(size_t *)block;
+		free(block);
+	}
+}
+
+void *operator new(size_t size) { return CountedAlloc(size); }
+void *operator new[](size_t size) { return CountedAlloc(size); }
+void operator delete(void *pointer) noexcept { CountedFree(pointer); }
+void operator delete[](void *pointer) noexcept { CountedFree(pointer); }
+void operator delete(void *pointer, size_t) noexcept { CountedFree(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { CountedFree(pointer); }
+
+namespace
+{
+	const double MB = 1024.0 * 1024.0;
+
+	//Reported when Unpack succeeds but gives back different text than was repacked
+	const int ErrMismatch = -1;
+
+	//Bytes from the end of the text the unpackTail stage unpacks
+	const unsigned int TailSize = 64 * 1024;
+
+	struct Options
+	{
+		std::string samplePath = "test/input.sav";
+		std::vector<unsigned int> sizesMB = { 1, 2, 4, 8, 16, 32, 64 };
+		unsigned int iterations = 10;
+		std::string workDir = ".";
+		std::string outPath;
+		unsigned int batchSize = 16; //Saves per UnpackBatch call in the unpackBatch stage
+		unsigned int threads = 0; //UnpackBatch threads, 0 for one per core
+	};
+
+	struct CorpusEntry
+	{
+		std::string label;
+		std::string packedPath; //Written by the repack stage, read by the others
+		std::string text;
+	};
+
+	struct StageResult
+	{
+		std::string input;
+		std::string stage;
+		size_t xmlBytes;
+		unsigned int iterations;
+		int errcode;
+		double mbPerSec;
+		double p50Ms;
+		double p90Ms;
+		double p99Ms;
+		unsigned long long peakRssBytes;
+		double allocationsPerRun;
+		double allocatedBytesPerRun;
+		long long peakHeapBytes;
+	};
+
+	unsigned long long PeakRss()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+			return counters.PeakWorkingSetSize;
+		return 0;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0;
+#ifdef __APPLE__
+		return (unsigned long long)usage.ru_maxrss;
+#else
+		return (unsigned long long)usage.ru_maxrss * 1024;
+#endif
+#endif
+	}
+
+	//Nearest-rank percentile of sorted samples
+	double Percentile(const std::vector<double> &sorted, double fraction)
+	{
+		size_t rank = (size_t)(fraction * sorted.size() + 0.999999);
+		if (rank < 1)
+			rank = 1;
+		if (rank > sorted.size())
+			rank = sorted.size();
+		return sorted[rank - 1];
+	}
+
+	// Runs one stage iterations times, timing each run and counting its allocations.
+	// MB/s counts bytesPerRun of unpacked text.
+	template <typename Run>
+	StageResult Measure(const CorpusEntry &entry, const char *stage, unsigned int iterations, size_t bytesPerRun, Run run)
+	{
+		StageResult result = {};
+		result.input = entry.label;
+		result.stage = stage;
+		result.xmlBytes = entry.text.size();
+		result.iterations = iterations;
+
+		std::vector<double> samples;
+		samples.reserve(iterations);
+
+		unsigned long long allocationsBefore = allocationCount;
+		unsigned long long bytesBefore = allocatedBytes;
+		long long liveBefore = liveBytes;
+		peakLiveBytes = liveBefore;
+
+		for (unsigned int i = 0; i < iterations && result.errcode == 0; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			result.errcode = run();
+			auto stop = std::chrono::steady_clock::now();
+			samples.push_back(std::chrono::duration<double, std::milli>(stop - start).count());
+		}
+
+		unsigned int runs = (unsigned int)samples.size();
+		result.allocationsPerRun = (double)(allocationCount - allocationsBefore) / runs;
+		result.allocatedBytesPerRun = (double)(allocatedBytes - bytesBefore) / runs;
+		result.peakHeapBytes = peakLiveBytes - liveBefore;
+		result.peakRssBytes = PeakRss();
+
+		std::sort(samples.begin(), samples.end());
+		result.p50Ms = Percentile(samples, 0.50);
+		result.p90Ms = Percentile(samples, 0.90);
+		result.p99Ms = Percentile(samples, 0.99);
+		result.mbPerSec = result.p50Ms > 0 ? (bytesPerRun / MB) / (result.p50Ms / 1000.0) : 0;
+		return result;
+	}
+
+	// Writes text as a packed save, like Repack but without its padding to SAVESIZE or refusal of larger
+	// saves, so the other stages have something to read for saves too big for a slot
+	int WriteOversizedSave(const char *packedPath, const std::string &text)
+	{
+		long size = (long)text.size();
+		std::vector<unsigned char> packed(sizeof(header_s) + EZ_COMPRESSMAXDESTLENGTH(size));
+		long streamSize = (long)(packed.size() - sizeof(header_s));
+		int errcode = ezcompress(&packed[sizeof(header_s)], &streamSize, (const unsigned char *)text.data(), size);
+		if (errcode != 0)
+			return errcode;
+
+		//The same constants as DDsavelib's InitHeader
+		header_s header;
+		header.u1 = 21;
+		header.u2 = 860693325;
+		header.u3 = 0;
+		header.u4 = 860700740;
+		header.u5 = 1079398965;
+		header.compressedSize = (unsigned int)streamSize;
+		header.realSize = (unsigned int)size;
+		header.hash = crc32jam(&packed[sizeof(header_s)], streamSize);
+		memcpy(packed.data(), &header, sizeof(header_s));
+
+		FILE *file = fopen(packedPath, "wb");
+		if (!file)
+			return ERR_WRITE;
+		size_t packedSize = sizeof(header_s) + streamSize;
+		errcode = fwrite(packed.data(), 1, packedSize, file) == packedSize ? 0 : ERR_WRITE;
+		if (fclose(file) != 0 && !errcode)
+			errcode = ERR_WRITE;
+		return errcode;
+	}
+
+	//Counts the text UnpackBatch hands over without keeping it
+	int CountWindow(const char *data, unsigned int size, void *userData)
+	{
+		(void)data;
+		*(unsigned long long *)userData += size;
+		return 0;
+	}
+
+	void BenchEntry(const CorpusEntry &entry, const Options &options, std::vector<StageResult> &results)
+	{
+		unsigned int iterations = options.iterations;
+		const char *text = entry.text.data();
+		unsigned int size = (unsigned int)entry.text.size();
+		const char *packedPath = entry.packedPath.c_str();
+
+		results.push_back(Measure(entry, "repack", iterations, size, [&]()
+		{
+			return Repack(packedPath, text, size);
+		}));
+
+		int errcode = results.back().errcode;
+		SavContext *context = 0;
+		if (errcode == 0 && SavContextOpen(0, &context) == 0)
+		{
+			//Once the context has written the text, repacking it there writes the same bytes back
+			errcode = SavContextRepack(context, packedPath, text, size, SAVPROFILE_BALANCED, 0);
+			if (!errcode)
+			{
+				results.push_back(Measure(entry, "repackUnchanged", iterations, size, [&]()
+				{
+					return SavContextRepack(context, packedPath, text, size, SAVPROFILE_BALANCED, 0);
+				}));
+			}
+			SavContextClose(context);
+		}
+		else if (errcode == ERR_TOOLARGE)
+		{
+			//Large synthetic saves compress to more than a save slot holds, so they are written without its limit
+			errcode = WriteOversizedSave(packedPath, entry.text);
+		}
+		if (errcode)
+		{
+			fprintf(stderr, "Could not write %s, skipping %s\n", packedPath, entry.label.c_str());
+			return;
+		}
+
+		std::vector<char> buffer(size);
+		results.push_back(Measure(entry, "unpack", iterations, size, [&]()
+		{
+			int errcode = Unpack(packedPath, buffer.data());
+			if (!errcode && memcmp(buffer.data(), text, size) != 0)
+				errcode = ErrMismatch;
+			return errcode;
+		}));
+
+		//Once the context has unpacked the save it knows its access points, so this only inflates from the last one
+		unsigned int tailSize = size < TailSize ? size : TailSize;
+		SavContext *tailContext = 0;
+		if (SavContextOpen(1, &tailContext) == 0)
+		{
+			if (SavContextUnpack(tailContext, packedPath, buffer.data(), size) == 0)
+			{
+				results.push_back(Measure(entry, "unpackTail", iterations, tailSize, [&]()
+				{
+					int errcode = SavContextUnpackRange(tailContext, packedPath, size - tailSize, tailSize, buffer.data());
+					if (!errcode && memcmp(buffer.data(), text + size - tailSize, tailSize) != 0)
+						errcode = ErrMismatch;
+					return errcode;
+				}));
+			}
+			SavContextClose(tailContext);
+		}
+
+		results.push_back(Measure(entry, "validate", iterations, size, [&]()
+		{
+			return Validate(packedPath);
+		}));
+
+		std::vector<SavBatchItem> items(options.batchSize);
+		std::vector<unsigned long long> counts(options.batchSize);
+		results.push_back(Measure(entry, "unpackBatch", iterations, (size_t)size * options.batchSize, [&]()
+		{
+			for (unsigned int i = 0; i < options.batchSize; ++i)
+			{
+				counts[i] = 0;
+				items[i] = SavBatchItem();
+				items[i].pathPackedSav = packedPath;
+				items[i].callback = CountWindow;
+				items[i].userData = &counts[i];
+			}
+			int errcode = UnpackBatch(items.data(), options.batchSize, options.threads, 0);
+			for (unsigned int i = 0; !errcode && i < options.batchSize; ++i)
+			{
+				if (counts[i] != size)
+					errcode = ErrMismatch;
+			}
+			return errcode;
+		}));
+	}
+
+	// Creates the directory the packed saves are written to, unless it is already there
+	bool MakeWorkDir(const std::string &path)
+	{
+#ifdef _WIN32
+		if (_mkdir(path.c_str()) == 0)
+			return true;
+#else
+		if (mkdir(path.c_str(), 0777) == 0)
+			return true;
+#endif
+		struct stat info;
+		return errno == EEXIST && stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFMT) == S_IFDIR;
+	}
+
+	bool LoadSample(const std::string &path, std::string *outText)
+	{
+		unsigned int size = 0;
+		if (GetUnpackedSize(path.c_str(), &size) != 0)
+			return false;
+		outText->resize(size);
+		return UnpackToBuffer(path.c_str(), &(*outText)[0], size) == 0;
+	}
+
+	void WriteJson(FILE *out, const Options &options, const std::vector<StageResult> &results)
+	{
+		fprintf(out, "{\n  \"benchmark\": \"DDsavelib\",\n  \"iterations\": %u,\n  \"results\": [\n", options.iterations);
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const StageResult &r = results[i];
+			fprintf(out,
+				"    {\"input\": \"%s\", \"stage\": \"%s\", \"xmlBytes\": %llu, \"iterations\": %u, \"error\": %d, "
+				"\"mbPerSec\": %.2f, \"p50Ms\": %.3f, \"p90Ms\": %.3f, \"p99Ms\": %.3f, \"peakRssBytes\": %llu, "
+				"\"allocationsPerRun\": %.1f, \"allocatedBytesPerRun\": %.0f, \"peakHeapBytes\": %lld}%s\n",
+				r.input.c_str(), r.stage.c_str(), (unsigned long long)r.xmlBytes, r.iterations, r.errcode,
+				r.mbPerSec, r.p50Ms, r.p90Ms, r.p99Ms, r.peakRssBytes,
+				r.allocationsPerRun, r.allocatedBytesPerRun, r.peakHeapBytes,
+				i + 1 < results.size() ? "," : "");
+		}
+		fprintf(out, "  ]\n}\n");
+	}
+
+	bool ParseOptions(int argc, char **argv, Options *options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			if (i + 1 >= argc)
+				return false;
+			std::string value = argv[++i];
+			if (arg == "--sample")
+			{
+				options->samplePath = value;
+			}
+			else if (arg == "--sizes")
+			{
+				options->sizesMB.clear();
+				for (const char *p = value.c_str(); *p; )
+				{
+					char *end;
+					unsigned long sizeMB = strtoul(p, &end, 10);
+					if (end == p || sizeMB == 0)
+						return false;
+					options->sizesMB.push_back((unsigned int)sizeMB);
+					p = *end == ',' ? end + 1 : end;
+				}
+			}
+			else if (arg == "--iterations")
+			{
+				options->iterations = (unsigned int)strtoul(value.c_str(), 0, 10);
+				if (options->iterations == 0)
+					return false;
+			}
+			else if (arg == "--batch")
+			{
+				options->batchSize = (unsigned int)strtoul(value.c_str(), 0, 10);
+				if (options->batchSize == 0)
+					return false;
+			}
+			else if (arg == "--threads")
+			{
+				options->threads = (unsigned int)strtoul(value.c_str(), 0, 10);
+			}
+			else if (arg == "--workdir")
+			{
+				options->workDir = value;
+			}
+			else if (arg == "--out")
+			{
+				options->outPath = value;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		fprintf(stderr, "Usage: DDsavelibBench [--sample path] [--sizes 1,2,4] [--iterations n] [--workdir dir] [--out file]"
+			" [--batch n] [--threads n]\n");
+		return 2;
+	}
+
+	if (!MakeWorkDir(options.workDir))
+	{
+		fprintf(stderr, "Could not create the work directory %s\n", options.workDir.c_str());
+		return 1;
+	}
+
+	std::vector<StageResult> results;
+
+	CorpusEntry sample;
+	sample.label = options.samplePath;
+	sample.packedPath = options.workDir + "/bench_sample.sav";
+	if (LoadSample(options.samplePath, &sample.text))
+	{
+		BenchEntry(sample, options, results);
+		remove(sample.packedPath.c_str());
+	}
+	else
+	{
+		fprintf(stderr, "Could not unpack %s, skipping it\n", options.samplePath.c_str());
+	}
+	std::string().swap(sample.text);
+
+	for (unsigned int sizeMB : options.sizesMB)
+	{
+		CorpusEntry synthetic;
+		synthetic.label = "synthetic-" + std::to_string(sizeMB) + "MB";
+		synthetic.packedPath = options.workDir + "/bench_" + std::to_string(sizeMB) + "MB.sav";
+		synthetic.text = WriteSyntheticSave((size_t)sizeMB * 1024 * 1024, sizeMB);
+		BenchEntry(synthetic, options, results);
+		remove(synthetic.packedPath.c_str());
+	}
+
+	FILE *out = stdout;
+	if (!options.outPath.empty())
+	{
+		out = fopen(options.outPath.c_str(), "w");
+		if (!out)
+		{
+			fprintf(stderr, "Could not open %s for writing\n", options.outPath.c_str());
+			return 1;
+		}
+	}
+	WriteJson(out, options, results);
+	if (out != stdout)
+		fclose(out);
+
+	for (const StageResult &r : results)
+	{
+		if (r.errcode && r.errcode != ERR_TOOLARGE)
+			return 1;
+	}
+	return 0;
+}
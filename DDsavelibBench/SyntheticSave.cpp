@@ -0,0 +1,242 @@
+// SyntheticSave.cpp : Generates save-shaped XML of any size for the benchmark corpus.
+//
+
+#include "SyntheticSave.h"
+
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+	// xorshift32, so the corpus doesn't depend on the standard library's generators
+	class Random
+	{
+	public:
+		explicit Random(unsigned int seed) : state(seed ? seed : 0x9E3779B9) {}
+
+		unsigned int Next()
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state;
+		}
+
+		unsigned int Below(unsigned int bound) { return Next() % bound; }
+
+	private:
+		unsigned int state;
+	};
+
+	//Scalar types weighted by how often a real save has them (thousands of elements)
+	struct ScalarType
+	{
+		const char *tag;
+		unsigned int weight;
+	};
+
+	const ScalarType ScalarTypes[] = {
+		{ "u32", 155 }, { "u8", 133 }, { "u16", 78 }, { "s8", 72 }, { "s16", 66 },
+		{ "s32", 64 }, { "f32", 44 }, { "bool", 13 }, { "u64", 3 }
+	};
+
+	//Class types in the corpus; a real save repeats a few hundred types over and over
+	const unsigned int LayoutCount = 24;
+
+	//Nesting of class members below each top-level class
+	const unsigned int MaxDepth = 4;
+
+	const char *PickScalarType(Random &random)
+	{
+		unsigned int total = 0;
+		for (const ScalarType &type : ScalarTypes)
+			total += type.weight;
+		unsigned int pick = random.Below(total);
+		for (const ScalarType &type : ScalarTypes)
+		{
+			if (pick < type.weight)
+				return type.tag;
+			pick -= type.weight;
+		}
+		return ScalarTypes[0].tag;
+	}
+
+	enum MemberShape
+	{
+		ShapeScalar,
+		ShapeArray,
+		ShapeVector3,
+		ShapeString,
+		ShapeClass
+	};
+
+	struct Member
+	{
+		MemberShape shape;
+		const char *tag; //Scalar and array item type
+		unsigned int count; //Array items
+		unsigned int layout; //Class type
+	};
+
+	// The members of one class type. Every instance of a type has the same members in the same order,
+	// as in a real save, where most of the text is the same few class types with mostly default values.
+	struct Layout
+	{
+		std::vector<Member> members;
+		bool hasName; //Character-like classes have a name array, like mEdit's (u8*)mNameStr
+	};
+
+	std::vector<Layout> MakeLayouts(Random &random)
+	{
+		std::vector<Layout> layouts(LayoutCount);
+		for (unsigned int i = 0; i < LayoutCount; ++i)
+		{
+			Layout &layout = layouts[i];
+			layout.hasName = i % 8 == 0;
+			unsigned int members = 8 + random.Below(16);
+			for (unsigned int j = 0; j < members; ++j)
+			{
+				Member member = { ShapeScalar, PickScalarType(random), 0, 0 };
+				unsigned int shape = random.Below(100);
+				if (shape < 6)
+				{
+					member.shape = ShapeArray;
+					member.count = 4 << random.Below(4);
+				}
+				else if (shape < 7)
+				{
+					member.shape = ShapeVector3;
+				}
+				else if (shape < 8)
+				{
+					member.shape = ShapeString;
+				}
+				else if (shape < 9 && i + 1 < LayoutCount)
+				{
+					//Only later types nest, so no type contains itself
+					member.shape = ShapeClass;
+					member.layout = i + 1 + random.Below(LayoutCount - i - 1);
+				}
+				layout.members.push_back(member);
+			}
+		}
+		return layouts;
+	}
+
+	void AppendValue(std::string &text, const char *tag, Random &random)
+	{
+		std::string type = tag;
+		char value[32];
+		//Nearly every value in a real save is left at its default, which is why saves compress so well
+		if (random.Below(400) != 0)
+			snprintf(value, sizeof(value), "%s", type == "f32" ? "0.000000" : type == "bool" ? "false" : "0");
+		else if (type == "f32")
+			snprintf(value, sizeof(value), "%f", (double)(int)random.Below(64) / 4.0);
+		else if (type == "bool")
+			snprintf(value, sizeof(value), "%s", "true");
+		else if (type[0] == 's')
+			snprintf(value, sizeof(value), "%d", (int)random.Below(20) - 10);
+		else
+			snprintf(value, sizeof(value), "%u", random.Below(8) ? random.Below(100) : random.Below(100000));
+		text += value;
+	}
+
+	void AppendScalar(std::string &text, const char *tag, const char *name, Random &random)
+	{
+		text += '<';
+		text += tag;
+		if (name)
+		{
+			text += " name=\"";
+			text += name;
+			text += '"';
+		}
+		text += " value=\"";
+		AppendValue(text, tag, random);
+		text += "\"/>\n";
+	}
+
+	void AppendArray(std::string &text, const char *name, const char *tag, unsigned int count, Random &random)
+	{
+		char header[128];
+		snprintf(header, sizeof(header), "<array name=\"%s\" type=\"%s\" count=\"%u\">\n", name, tag, count);
+		text += header;
+		for (unsigned int i = 0; i < count; ++i)
+			AppendScalar(text, tag, 0, random);
+		text += "</array>\n";
+	}
+
+	void AppendClass(	std::string &text,
+						const std::vector<Layout> &layouts,
+						unsigned int layoutIndex,
+						const char *name,
+						unsigned int depth,
+						Random &random)
+	{
+		char line[128];
+		snprintf(line, sizeof(line), "<class name=\"%s\" type=\"cSAVE_BENCH_%u\">\n", name, layoutIndex);
+		text += line;
+
+		const Layout &layout = layouts[layoutIndex];
+		for (size_t i = 0; i < layout.members.size(); ++i)
+		{
+			const Member &member = layout.members[i];
+			char memberName[32];
+			snprintf(memberName, sizeof(memberName), "mValue%u", (unsigned int)i);
+			switch (member.shape)
+			{
+			case ShapeArray:
+				AppendArray(text, memberName, member.tag, member.count, random);
+				break;
+			case ShapeVector3:
+				snprintf(line, sizeof(line), "<vector3 name=\"%s\" x=\"%f\" y=\"0.000000\" z=\"0.000000\"/>\n",
+					memberName, random.Below(16) ? 0.0 : (double)(int)random.Below(16) / 4.0);
+				text += line;
+				break;
+			case ShapeString:
+				snprintf(line, sizeof(line), "<string name=\"%s\" value=\"scr\\st%03u\\fsm\"/>\n", memberName, random.Below(16) ? 0 : random.Below(16));
+				text += line;
+				break;
+			case ShapeClass:
+				if (depth < MaxDepth)
+				{
+					AppendClass(text, layouts, member.layout, memberName, depth + 1, random);
+					break;
+				}
+				AppendScalar(text, member.tag, memberName, random);
+				break;
+			default:
+				AppendScalar(text, member.tag, memberName, random);
+				break;
+			}
+		}
+
+		if (layout.hasName)
+			AppendArray(text, "(u8*)mNameStr", "u8", 25, random);
+
+		text += "</class>\n";
+	}
+}
+
+std::string WriteSyntheticSave(size_t targetSize, unsigned int seed)
+{
+	Random random(seed);
+	std::vector<Layout> layouts = MakeLayouts(random);
+
+	std::string text;
+	text.reserve(targetSize + 4096);
+	text += "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+	text += "<class name=\"dd_savedata1018\" type=\"sSave::saveDataAllDA\">\n";
+
+	//Long runs of one type, like a save's item and map lists
+	const size_t closing = sizeof("</class>\n") - 1;
+	for (unsigned int index = 0; text.size() + closing < targetSize; ++index)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "mItem%u", index);
+		AppendClass(text, layouts, (index / 64) % LayoutCount, name, 1, random);
+	}
+
+	text += "</class>\n";
+	return text;
+}
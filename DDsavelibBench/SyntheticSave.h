@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+
+// Writes unpacked save text of about targetSize bytes, shaped like a real save: nested classes of
+// named scalars in roughly the proportions a DDDA save has them, fixed-size arrays of unnamed
+// items, name arrays and the odd vector3 and string. The same seed always gives the same text.
+std::string WriteSyntheticSave(size_t targetSize, unsigned int seed);
@@ -7,11 +7,13 @@ namespace DDsavelibTest
 {
     class Program
     {
-        const int AllocSize = 30 * 1024 * 1024;
         const string Path = "../test/";
 
         [DllImport("DDsavelib.dll", CallingConvention = CallingConvention.Cdecl)]
-        private static extern int Unpack([MarshalAs(UnmanagedType.LPStr)]string savPath, IntPtr unpackedSavPtr);
+        private static extern int GetUnpackedSize([MarshalAs(UnmanagedType.LPStr)]string savPath, out uint unpackedSize);
+
+        [DllImport("DDsavelib.dll", CallingConvention = CallingConvention.Cdecl)]
+        private static extern int UnpackToBuffer([MarshalAs(UnmanagedType.LPStr)]string savPath, IntPtr unpackedSavPtr, uint bufferSize);
 
         [DllImport("DDsavelib.dll", CallingConvention = CallingConvention.Cdecl)]
         private static extern int Repack([MarshalAs(UnmanagedType.LPStr)]string outputPath,
@@ -29,12 +31,17 @@ static void TestValidate(string path)
 
         static XElement TestUnpack(string path, out string xmlText)
         {
-            IntPtr unpackedSavPtr = Marshal.AllocHGlobal(AllocSize);
-            int result = Unpack(path, unpackedSavPtr);
+            uint unpackedSize;
+            int result = GetUnpackedSize(path, out unpackedSize);
+            Console.WriteLine("GetUnpackedSize result: {0}, size: {1}", result, unpackedSize);
+
+            IntPtr unpackedSavPtr = Marshal.AllocHGlobal((int)unpackedSize);
+            result = UnpackToBuffer(path, unpackedSavPtr, unpackedSize);
 
             Console.WriteLine("Unpack result: {0}", result);
 
-            xmlText = Marshal.PtrToStringAnsi(unpackedSavPtr);
+            xmlText = Marshal.PtrToStringAnsi(unpackedSavPtr, (int)unpackedSize);
+            Marshal.FreeHGlobal(unpackedSavPtr);
 
             XElement root = XElement.Parse(xmlText, LoadOptions.PreserveWhitespace);
 
@@ -0,0 +1,499 @@
+// Tests.cpp : Round-trip and unit tests for DDsavelib, run by ctest.
+//
+// Usage: DDsavelibTests [sample path] [work dir]
+//
+// The sample save (test/input.sav by default) is unpacked, patched, repacked and unpacked again through the
+// exports, and the pieces behind them (SavXml, SavPath, PatchText, SavBinary, ParallelDeflate, SavIndex) are
+// checked on small texts of their own. Files are written to the work dir (the current directory by default).
+// DDsavelib is compiled into this executable, like the benchmark, so its internals can be called directly.
+// Prints each failed check and exits with 1 if there were any.
+
+#include "DDsavelib.h"
+#include "SavContext.h"
+#include "SavDeflate.h"
+#include "SavFormat.h"
+#include "SavIndex.h"
+#include "SavPatch.h"
+#include "SavPath.h"
+#include "SavXml.h"
+#include "easyzlib.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	unsigned int failures = 0;
+
+	void Check(bool condition, const char *test, const char *what)
+	{
+		if (condition)
+			return;
+		fprintf(stderr, "FAILED %s: %s\n", test, what);
+		++failures;
+	}
+
+	// xorshift32, so the offsets tried are the same on every run
+	class Random
+	{
+	public:
+		explicit Random(unsigned int seed) : state(seed) {}
+
+		unsigned int Below(unsigned int bound)
+		{
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			return state % bound;
+		}
+
+	private:
+		unsigned int state;
+	};
+
+	bool ReadWholeFile(const std::string &path, std::vector<unsigned char> *outData)
+	{
+		FILE *file = fopen(path.c_str(), "rb");
+		if (!file)
+			return false;
+		outData->clear();
+		unsigned char block[64 * 1024];
+		size_t read;
+		while ((read = fread(block, 1, sizeof(block), file)) > 0)
+			outData->insert(outData->end(), block, block + read);
+		fclose(file);
+		return true;
+	}
+
+	bool WriteWholeFile(const std::string &path, const void *data, size_t size)
+	{
+		FILE *file = fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+		bool written = fwrite(data, 1, size, file) == size;
+		return fclose(file) == 0 && written;
+	}
+
+	bool CopyFile(const std::string &from, const std::string &to)
+	{
+		std::vector<unsigned char> data;
+		return ReadWholeFile(from, &data) && WriteWholeFile(to, data.data(), data.size());
+	}
+
+	int UnpackWhole(const std::string &path, std::string *outText)
+	{
+		unsigned int size = 0;
+		int errcode = GetUnpackedSize(path.c_str(), &size);
+		if (errcode)
+			return errcode;
+		outText->assign(size, '\0');
+		return UnpackToBuffer(path.c_str(), &(*outText)[0], size);
+	}
+
+	// The compressed payload after a packed save's header
+	std::vector<unsigned char> ReadPayload(const std::string &path)
+	{
+		std::vector<unsigned char> data;
+		if (!ReadWholeFile(path, &data) || data.size() < sizeof(header_s))
+			return std::vector<unsigned char>();
+		const header_s *header = (const header_s *)data.data();
+		size_t end = sizeof(header_s) + header->compressedSize;
+		return std::vector<unsigned char>(data.begin() + sizeof(header_s), data.begin() + (end < data.size() ? end : data.size()));
+	}
+
+	size_t CommonPrefix(const std::vector<unsigned char> &a, const std::vector<unsigned char> &b)
+	{
+		size_t size = a.size() < b.size() ? a.size() : b.size();
+		size_t i = 0;
+		while (i < size && a[i] == b[i])
+			++i;
+		return i;
+	}
+
+	// Changes a value="0" about at of the way through text to value="7", keeping its length
+	size_t EditValueNear(std::string &text, double at)
+	{
+		size_t offset = text.find("value=\"0\"", (size_t)(text.size() * at));
+		if (offset != std::string::npos)
+			text[offset + 7] = '7';
+		return offset;
+	}
+
+	// Reads events until the root closes, giving the first error
+	int ReadAll(const char *text, unsigned int *outStarts = 0)
+	{
+		SavXmlReader reader(text, (unsigned int)strlen(text));
+		SavXmlEvent e;
+		unsigned int starts = 0;
+		int ends = 0;
+		while (true)
+		{
+			int errcode = reader.Next(&e);
+			if (errcode)
+				return errcode;
+			if (e.kind == SAVXML_EOF)
+				break;
+			if (e.kind == SAVXML_START)
+				++starts;
+			else
+				++ends;
+		}
+		if (outStarts)
+			*outStarts = starts;
+		return (int)starts == ends ? 0 : -1;
+	}
+
+	const char SmallText[] =
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<class name=\"root\" type=\"sSave\">\n"
+		"<u32 name=\"mFirst\" value=\"10\"/>\n"
+		"<array name=\"mList\" type=\"u8\" count=\"3\">\n"
+		"<u8 value=\"1\"/>\n"
+		"<u8 value=\"2\"/>\n"
+		"<u8 name=\"mNamed\" value=\"3\"/>\n"
+		"</array>\n"
+		"<class name=\"mInner\" type=\"cInner\">\n"
+		"<s16 name=\"mValue\" value=\"-4\"/>\n"
+		"<string name=\"mText\" value=\"a &amp; b\"/>\n"
+		"</class>\n"
+		"<u32 name=\"mFirst\" value=\"20\"/>\n"
+		"</class>\n";
+
+	void TestSavXml(const std::string &text)
+	{
+		const char *test = "SavXml";
+		SavXmlReader reader(SmallText, sizeof(SmallText) - 1);
+		SavXmlEvent e;
+		Check(reader.Next(&e) == 0 && e.kind == SAVXML_START && e.depth == 0 && SpanEquals(e.name, "root"), test, "root start");
+		Check(reader.Next(&e) == 0 && e.kind == SAVXML_START && e.isEmpty && e.depth == 1 && SpanEquals(e.value, "10"), test, "self-closing start");
+		Check(SpanEquals(e.tag, "u32") && SpanEquals(e.name, "mFirst"), test, "tag and name");
+		Check(reader.OffsetOf(e.value) == (unsigned int)(strstr(SmallText, "\"10\"") + 1 - SmallText), test, "value offset");
+		Check(reader.Next(&e) == 0 && e.kind == SAVXML_END && e.depth == 1, test, "self-closing end");
+		Check(reader.Next(&e) == 0 && e.kind == SAVXML_START && e.count == 3 && SpanEquals(e.type, "u8"), test, "array count and type");
+
+		unsigned int starts = 0;
+		Check(ReadAll(SmallText, &starts) == 0 && starts == 10, test, "every element of the small text");
+		Check(ReadAll(text.c_str()) == 0, test, "the sample reads to the end");
+
+		//Malformed text is rejected, not read past
+		Check(ReadAll("") == ERR_FORMAT, test, "no root");
+		Check(ReadAll("<a name=\"x\">\n</b>\n") == ERR_FORMAT, test, "mismatched end tag");
+		Check(ReadAll("<a name=\"x\">\n<b>\n</a>\n") == ERR_FORMAT, test, "end tag of an outer element");
+		Check(ReadAll("<a name=\"x>\n</a>\n") != 0, test, "unterminated attribute");
+		Check(ReadAll("<a>\n<b/>\n") != 0, test, "unclosed root");
+		std::string deep;
+		for (unsigned int i = 0; i <= SAVXML_MAXDEPTH; ++i)
+			deep += "<c>";
+		for (unsigned int i = 0; i <= SAVXML_MAXDEPTH; ++i)
+			deep += "</c>";
+		Check(ReadAll(deep.c_str()) == ERR_FORMAT, test, "nesting deeper than SAVXML_MAXDEPTH");
+	}
+
+	void TestSavPath()
+	{
+		const char *test = "SavPath";
+		const char *paths[] = { "mFirst", "mList/#1", "mInner/mValue", "mInner/mText", "mMissing", "mList/#7", "mList/mNamed", "mList/#2", "mFirst" };
+		const unsigned int count = sizeof(paths) / sizeof(paths[0]);
+		SavValueSpan spans[count];
+		SavPathMatcher matcher(paths, count);
+		Check(matcher.Resolve(SmallText, sizeof(SmallText) - 1, spans) == 0, test, "Resolve");
+
+		auto value = [&](unsigned int i)
+		{
+			return spans[i].offset == SAVPATH_NOTFOUND ? std::string("(not found)") : std::string(SmallText + spans[i].offset, spans[i].size);
+		};
+		Check(value(0) == "10", test, "only the first of two elements with a name is matched");
+		Check(value(1) == "2", test, "#N counts children from 0");
+		Check(value(2) == "-4", test, "nested name");
+		Check(value(3) == "a &amp; b", test, "entities are left as written");
+		Check(spans[4].offset == SAVPATH_NOTFOUND && spans[5].offset == SAVPATH_NOTFOUND, test, "missing elements");
+		Check(value(6) == "3", test, "an element with a name is matched by it");
+		Check(spans[7].offset == SAVPATH_NOTFOUND, test, "a name goes before an index for the same element");
+		Check(value(8) == "10", test, "a duplicate path gets the same span");
+
+		SavPathMatcher broken(paths, count);
+		Check(broken.Resolve("<a>\n</b>\n", 9, spans) == ERR_FORMAT, test, "malformed text");
+	}
+
+	void TestPatchText()
+	{
+		const char *test = "PatchText";
+		const char text[] = "<a value=\"1\"/>\n<b value=\"22\"/>\n";
+		const unsigned int size = sizeof(text) - 1;
+		SavValueSpan spans[] = { { 25, 2 }, { 10, 1 }, { 25, 2 } };
+		const char *values[] = { "x", "long", "333" };
+		char out[64];
+		unsigned int outSize = 0;
+		Check(PatchText(text, size, spans, values, 3, out, sizeof(out), &outSize) == 0, test, "PatchText");
+		Check(std::string(out, outSize) == "<a value=\"long\"/>\n<b value=\"333\"/>\n", test, "edits out of order, the later of two on a span wins");
+
+		Check(PatchText(text, size, spans, values, 3, out, 10, &outSize) == ERR_BUFFERSIZE && outSize == size + 4, test, "too little room gives the size needed");
+		SavValueSpan outside[] = { { size, 4 } };
+		Check(PatchText(text, size, outside, values, 1, out, sizeof(out), &outSize) == ERR_FORMAT, test, "span past the end");
+
+		//PatchXml skips edits of elements that aren't there
+		SavXmlEdit edits[] = { { "mMissing", "5" }, { "mInner/mValue", "12" } };
+		std::string patched(sizeof(SmallText) + 8, '\0');
+		Check(PatchXml(SmallText, sizeof(SmallText) - 1, edits, 2, &patched[0], (unsigned int)patched.size(), &outSize) == 0, test, "PatchXml");
+		std::string expected = SmallText;
+		expected.replace(expected.find("\"-4\"") + 1, 2, "12");
+		Check(patched.substr(0, outSize) == expected, test, "PatchXml with a missing element");
+		Check(PatchXml("<a>\n</b>\n", 9, edits, 2, &patched[0], (unsigned int)patched.size(), &outSize) == ERR_FORMAT, test, "PatchXml on malformed text");
+	}
+
+	void TestSavBinary(const std::string &text)
+	{
+		const char *test = "SavBinary";
+		SavBinary *binary = 0;
+		Check(SavBinaryFromXml(text.data(), (unsigned int)text.size(), &binary) == 0, test, "SavBinaryFromXml");
+		if (!binary)
+			return;
+
+		unsigned int size = 0;
+		Check(SavBinaryGetXmlSize(binary, &size) == 0 && size == text.size(), test, "text size");
+		std::string back(size, '\0');
+		Check(SavBinaryToXml(binary, &back[0], size) == 0 && back == text, test, "gives back the exact text");
+		Check(size == 0 || SavBinaryToXml(binary, &back[0], size - 1) == ERR_BUFFERSIZE, test, "too little room");
+
+		SavBinaryRef ref;
+		long long value = 0;
+		Check(SavBinaryFind(binary, "mPlayerDataManual/mPlCmcEditAndParam/mCmc/#0/mEdit/(u8*)mNameStr/#0", &ref) == 0 &&
+			SavBinaryGetInt(binary, ref, &value) == 0 && value != 0, test, "reads the first letter of the player's name");
+		Check(SavBinaryFind(binary, "mNoSuchElement", &ref) == ERR_PATH, test, "missing path");
+		SavBinaryClose(binary);
+
+		SavBinary *small = 0;
+		Check(SavBinaryFromXml(SmallText, sizeof(SmallText) - 1, &small) == 0, test, "small text");
+		Check(small && SavBinaryFind(small, "mList/#1", &ref) == 0 && SavBinaryGetInt(small, ref, &value) == 0 && value == 2, test, "array item");
+		SavBinaryClose(small);
+
+		SavBinary *broken = 0;
+		Check(SavBinaryFromXml("<a>\n</b>\n", 9, &broken) == ERR_FORMAT && !broken, test, "malformed text");
+	}
+
+	void TestParallelDeflate(const std::string &text)
+	{
+		const char *test = "ParallelDeflate";
+		SavContext context(2);
+		SavArena *arena = context.streams.AcquireArena();
+		Check(arena != 0, test, "arena");
+		if (!arena)
+			return;
+
+		const unsigned char *data = (const unsigned char *)text.data();
+		unsigned int size = (unsigned int)text.size();
+		unsigned char *stream = 0;
+		unsigned int streamSize = 0;
+		std::vector<SavAccessPoint> points;
+		Check(ParallelDeflate(data, size, 1, EZ_DEFAULT_STRATEGY, context, *arena, 0xFFFFFFFF, &stream, &streamSize, 0, &points) == 0, test, "compress");
+
+		std::vector<unsigned char> inflated(size);
+		long inflatedSize = (long)size;
+		Check(ezuncompress(inflated.data(), &inflatedSize, stream, (long)streamSize) == 0 &&
+			inflatedSize == (long)size && memcmp(inflated.data(), data, size) == 0, test, "the pieces join into one zlib stream");
+		Check(points.size() >= size / SAVACCESS_SPAN, test, "an access point about every SAVACCESS_SPAN");
+
+		unsigned long long measured = 0;
+		Check(MeasureParallelDeflate(data, size, 1, EZ_DEFAULT_STRATEGY, context, *arena, &measured) == 0 && measured == streamSize, test, "measured size");
+
+		unsigned int tooSmall = streamSize / 2;
+		Check(ParallelDeflate(data, size, 1, EZ_DEFAULT_STRATEGY, context, *arena, tooSmall, &stream, &streamSize) == ERR_TOOLARGE, test, "capacity");
+		context.streams.ReleaseArena(arena);
+	}
+
+	void TestRoundTrip(const std::string &work, const std::string &text)
+	{
+		const char *test = "RoundTrip";
+		std::string unchanged;
+		std::string path = work + "/roundtrip.sav";
+		Check(Repack(path.c_str(), text.data(), (unsigned int)text.size()) == 0, test, "Repack");
+		Check(UnpackWhole(path, &unchanged) == 0 && unchanged == text, test, "unpack after repack");
+
+		//Patch the player's name and a value, repack the bytes and unpack them again
+		SavXmlEdit edits[] = {
+			{ "mPlayerDataManual/mPlCmcEditAndParam/mCmc/#0/mEdit/(u8*)mNameStr/#0", "90" },
+			{ "mPlayerDataManual/mPlCmcEditAndParam/mCmc/#0/mEdit/(u8*)mNameStr/#1", "246" },
+			{ "mNoSuchElement", "1" }
+		};
+		std::string patched(text.size() + 16, '\0');
+		unsigned int patchedSize = 0;
+		Check(PatchXml(text.data(), (unsigned int)text.size(), edits, 3, &patched[0], (unsigned int)patched.size(), &patchedSize) == 0, test, "PatchXml");
+		patched.resize(patchedSize);
+		Check(patched != text && patched.size() == text.size(), test, "patched text");
+
+		Check(RepackBytes(path.c_str(), (const unsigned char *)patched.data(), patched.size(), SAVPROFILE_BALANCED, 0) == 0, test, "RepackBytes");
+		std::string again;
+		Check(UnpackWhole(path, &again) == 0 && again == patched, test, "byte-exact after patch and repack");
+		Check(Verify(path.c_str()) == 0, test, "Verify");
+
+		Check(RepackEx(path.c_str(), text.data(), (unsigned int)text.size(), 7, 0) == ERR_ARGUMENT, test, "unknown profile");
+		Check(RepackEx(path.c_str(), text.data(), (unsigned int)text.size(), SAVPROFILE_SMALLEST, 100) == ERR_TOOLARGE, test, "budget");
+		Check(UnpackWhole(path, &again) == 0 && again == patched, test, "a save too large leaves the file untouched");
+	}
+
+	void TestUnpackRange(const std::string &sample, const std::string &text)
+	{
+		const char *test = "UnpackRange";
+		unsigned int size = (unsigned int)text.size();
+		SavContext *context = 0;
+		Check(SavContextOpen(1, &context) == 0, test, "SavContextOpen");
+		if (!context)
+			return;
+
+		//Once the context has unpacked the save, ranges are inflated from its access points
+		std::string whole(size, '\0');
+		Check(SavContextUnpack(context, sample.c_str(), &whole[0], size) == 0 && whole == text, test, "SavContextUnpack");
+
+		Random random(12345);
+		std::vector<char> range;
+		for (unsigned int i = 0; i < 24; ++i)
+		{
+			unsigned int length = 1 + random.Below(3 * SAVACCESS_SPAN / 2);
+			length = length < size ? length : size;
+			unsigned int offset = random.Below(size - length + 1);
+			range.assign(length, '\0');
+			Check(SavContextUnpackRange(context, sample.c_str(), offset, length, range.data()) == 0 &&
+				memcmp(range.data(), text.data() + offset, length) == 0, test, "SavContextUnpackRange at a random offset");
+			if (i % 6 == 0)
+			{
+				Check(UnpackRange(sample.c_str(), offset, length, range.data()) == 0 &&
+					memcmp(range.data(), text.data() + offset, length) == 0, test, "UnpackRange at a random offset");
+			}
+		}
+		Check(SavContextUnpackRange(context, sample.c_str(), size - 10, 10, range.data()) == 0 &&
+			memcmp(range.data(), text.data() + size - 10, 10) == 0, test, "the last bytes");
+		Check(SavContextUnpackRange(context, sample.c_str(), size - 10, 11, range.data()) == ERR_BUFFERSIZE, test, "past the end");
+		SavContextClose(context);
+	}
+
+	void TestResume(const std::string &work, const std::string &sample, const std::string &text)
+	{
+		const char *test = "Resume";
+		std::string path = work + "/resume.sav";
+		Check(CopyFile(sample, path), test, "copy the sample");
+		std::vector<unsigned char> original = ReadPayload(path);
+		unsigned int size = (unsigned int)text.size();
+
+		SavContext *context = 0;
+		Check(SavContextOpen(0, &context) == 0, test, "SavContextOpen");
+		if (!context)
+			return;
+		std::string edited(size, '\0');
+		Check(SavContextUnpack(context, path.c_str(), &edited[0], size) == 0 && edited == text, test, "SavContextUnpack");
+		Check(EditValueNear(edited, 0.9) != std::string::npos, test, "a value to edit");
+
+		//Most of the payload is kept from the original save, before the edit
+		Check(SavContextRepack(context, path.c_str(), edited.data(), size, SAVPROFILE_FASTEST, 0) == 0, test, "SavContextRepack");
+		std::vector<unsigned char> resumed = ReadPayload(path);
+		Check(CommonPrefix(original, resumed) > original.size() / 2, test, "the payload before the edit is kept");
+		std::string again;
+		Check(UnpackWhole(path, &again) == 0 && again == edited, test, "unpack after a resumed repack");
+
+		//Repacking the same text again writes the same bytes back
+		Check(SavContextRepack(context, path.c_str(), edited.data(), size, SAVPROFILE_FASTEST, 0) == 0 && ReadPayload(path) == resumed, test, "unchanged text");
+		SavContextClose(context);
+
+		//An edit of a document's text resumes from the document's payload
+		Check(CopyFile(sample, path), test, "copy the sample");
+		SavDocument *document = 0;
+		Check(UnpackDocument(path.c_str(), &document) == 0, test, "UnpackDocument");
+		if (!document)
+			return;
+		const char *documentText = 0;
+		unsigned int documentSize = 0;
+		Check(SavDocumentGetText(document, &documentText, &documentSize) == 0 && std::string(documentText, documentSize) == text, test, "document text");
+		std::string documentEdit = text;
+		EditValueNear(documentEdit, 0.8);
+		Check(SavDocumentRepackEdit(document, path.c_str(), (const unsigned char *)documentEdit.data(), documentEdit.size(), SAVPROFILE_FASTEST, 0) == 0, test, "SavDocumentRepackEdit");
+		Check(CommonPrefix(original, ReadPayload(path)) > original.size() / 2, test, "the document's payload before the edit is kept");
+		Check(UnpackWhole(path, &again) == 0 && again == documentEdit, test, "unpack after a document edit");
+		SavDocumentClose(document);
+	}
+
+	void TestIndex(const std::string &work, const std::string &sample, const std::string &text)
+	{
+		const char *test = "SavIndex";
+		std::string path = work + "/indexed.sav";
+		std::string indexPath = path + SAVINDEX_EXTENSION;
+		Check(CopyFile(sample, path), test, "copy the sample");
+		remove(indexPath.c_str());
+
+		const char *paths[] = {
+			"mPlayerDataManual/mPlCmcEditAndParam/mCmc/#0/mEdit/(u8*)mNameStr/#0",
+			"mPlayerDataManual/mPlCmcEditAndParam/mCmc/#1/mEdit/(u8*)mNameStr/#0",
+			"mNoSuchElement"
+		};
+		const unsigned int count = sizeof(paths) / sizeof(paths[0]);
+		unsigned int size = (unsigned int)text.size();
+		SavValueSpan first[count];
+		SavValueSpan second[count];
+
+		std::string unpacked(size, '\0');
+		Check(UnpackIndexed(path.c_str(), paths, count, &unpacked[0], size, first) == 0 && unpacked == text, test, "UnpackIndexed");
+		Check(first[0].offset != SAVPATH_NOTFOUND && first[1].offset != SAVPATH_NOTFOUND && first[2].offset == SAVPATH_NOTFOUND, test, "spans");
+
+		std::vector<unsigned char> packed;
+		Check(ReadWholeFile(path, &packed) && packed.size() >= sizeof(header_s), test, "read the save");
+		const header_s *header = (const header_s *)packed.data();
+		Check(LoadSavIndex(indexPath.c_str(), header->hash, header->realSize, paths, count, second) == 0 &&
+			memcmp(first, second, sizeof(first)) == 0, test, "the index next to the save holds the spans");
+		Check(LoadSavIndex(indexPath.c_str(), header->hash, header->realSize, paths, count - 1, second) != 0, test, "other paths miss");
+		Check(LoadSavIndex(indexPath.c_str(), header->hash + 1, header->realSize, paths, count, second) != 0, test, "another save misses");
+
+		//A context that has seen the save only inflates the text under the spans; UnpackIndexed always gives it all
+		SavContext *context = 0;
+		Check(SavContextOpen(1, &context) == 0, test, "SavContextOpen");
+		if (context)
+		{
+			Check(SavContextUnpack(context, path.c_str(), &unpacked[0], size) == 0, test, "SavContextUnpack");
+			std::string partial(size, '\0');
+			Check(SavContextUnpackSpans(context, path.c_str(), paths, count, &partial[0], size, second) == 0 &&
+				memcmp(first, second, sizeof(first)) == 0, test, "SavContextUnpackSpans");
+			for (unsigned int i = 0; i < 2; ++i)
+				Check(partial.compare(second[i].offset, second[i].size, text, second[i].offset, second[i].size) == 0, test, "text under a span");
+			SavContextClose(context);
+		}
+		unpacked.assign(size, '\0');
+		Check(UnpackIndexed(path.c_str(), paths, count, &unpacked[0], size, second) == 0 && unpacked == text, test, "UnpackIndexed from the index gives the whole text");
+
+		//A damaged index is a miss, and is written again
+		Check(WriteWholeFile(indexPath, "SIDX damaged", 12), test, "damage the index");
+		Check(UnpackIndexed(path.c_str(), paths, count, &unpacked[0], size, second) == 0 && memcmp(first, second, sizeof(first)) == 0, test, "damaged index");
+		Check(LoadSavIndex(indexPath.c_str(), header->hash, header->realSize, paths, count, second) == 0, test, "the index is written again");
+		remove(indexPath.c_str());
+	}
+}
+
+int main(int argc, char **argv)
+{
+	std::string sample = argc > 1 ? argv[1] : "test/input.sav";
+	std::string work = argc > 2 ? argv[2] : ".";
+
+	std::string text;
+	int errcode = UnpackWhole(sample, &text);
+	if (errcode)
+	{
+		fprintf(stderr, "Could not unpack %s: %d\n", sample.c_str(), errcode);
+		return 1;
+	}
+
+	TestSavXml(text);
+	TestSavPath();
+	TestPatchText();
+	TestSavBinary(text);
+	TestParallelDeflate(text);
+	TestRoundTrip(work, text);
+	TestUnpackRange(sample, text);
+	TestResume(work, sample, text);
+	TestIndex(work, sample, text);
+
+	if (failures)
+	{
+		fprintf(stderr, "%u checks failed\n", failures);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}
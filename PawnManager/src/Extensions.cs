@@ -53,29 +53,34 @@ public static XAttribute GetValueAttribute(this XElement xElement)
         /// <param name="xElement">The element with the 'value' attribute</param>
         /// <returns>The int value of the 'value' attribute</returns>
         public static Int64 GetParsedValueAttribute(this XElement xElement)
+        {
+            XAttribute valueAttribute = xElement.GetValueAttribute();
+            string name = xElement.GetNameAttribute();
+            return ParseSavValue(
+                valueAttribute == null ? null : valueAttribute.Value,
+                name == null ? xElement.Name.ToString() : string.Format("with name={0}", name));
+        }
+
+        /// <summary>
+        /// Returns the int representation of a .sav element's 'value' attribute.
+        /// Throws an exception if it isn't a number.
+        /// </summary>
+        /// <param name="value">The 'value' attribute</param>
+        /// <param name="extraInfo">Describes the element in the exception message</param>
+        /// <returns>The int value of the 'value' attribute</returns>
+        public static Int64 ParseSavValue(string value, string extraInfo)
         {
             try
             {
-                string valueAttribute = xElement.GetValueAttribute().Value;
                 Int64 result;
-                if (Int64.TryParse(valueAttribute, out result))
+                if (Int64.TryParse(value, out result))
                 {
                     return result;
                 }
-                return (Int64)float.Parse(valueAttribute);
+                return (Int64)float.Parse(value);
             }
             catch (Exception ex)
             {
-                string extraInfo = null;
-                string name = xElement.GetNameAttribute();
-                if (name != null)
-                {
-                    extraInfo = string.Format("with name={0}", name);
-                }
-                else
-                {
-                    extraInfo = xElement.Name.ToString();
-                }
                 throw new XmlException(string.Format(
                     "Element {0} does not have a valid value attribute",
                     extraInfo),
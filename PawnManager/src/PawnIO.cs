@@ -157,16 +157,24 @@ private abstract class SavConfigElement
             public abstract void LoadPawnToSav(PawnData pawn, XElement xElement, SavSlot savSlot);
             public abstract void LoadSavToPawn(PawnData pawn, XElement xElement, SavSlot savSlot);
 
+            /// <summary>
+            /// Adds the parameters under this element to the table,
+            /// skipping any whose conditions exclude the given Pawn
+            /// </summary>
+            /// <param name="path">The path of this element's .sav element</param>
+            /// <param name="isWriteOnly">Whether an enclosing class is write-only</param>
+            public abstract void CompilePaths(SavPathTable table, string path, SavSlot savSlot, bool isWriteOnly);
+
+            protected static string ChildPath(string path, string childSegment)
+            {
+                return path.Length == 0 ? childSegment : path + SavPathTable.Separator + childSegment;
+            }
+
             protected static void LoadParameterToSav(PawnParameter parameter, XElement xElement)
             {
                 try
                 {
-                    string parameterString = (parameter.Value.ToInt64()).ToString();
-                    if (parameter.FormatAsFloat)
-                    {
-                        parameterString += ".000000";
-                    }
-                    xElement.GetValueAttribute().Value = parameterString;
+                    xElement.GetValueAttribute().Value = FormatSavValue(parameter);
                 }
                 catch (Exception ex)
                 {
@@ -235,6 +243,23 @@ public override void LoadSavToPawn(PawnData pawn, XElement xElement, SavSlot sav
                     }
                 }
             }
+
+            public override void CompilePaths(SavPathTable table, string path, SavSlot savSlot, bool isWriteOnly)
+            {
+                if (ParseCondition != null)
+                {
+                    if (!ParseCondition.AllowedPawns.Contains(savSlot))
+                    {
+                        return;
+                    }
+                    isWriteOnly |= ParseCondition.IsWriteOnly;
+                }
+
+                foreach (SavConfigElement child in Children)
+                {
+                    child.CompilePaths(table, ChildPath(path, child.Name), savSlot, isWriteOnly);
+                }
+            }
         }
 
         private class SavConfigParameter : SavConfigElement
@@ -282,6 +307,16 @@ public override void LoadSavToPawn(PawnData pawn, XElement xElement, SavSlot sav
                 pawnParameter.Value = xElement.GetParsedValueAttribute();
             }
 
+            public override void CompilePaths(SavPathTable table, string path, SavSlot savSlot, bool isWriteOnly)
+            {
+                table.Add(path, new SavPathEntry
+                {
+                    Key = Key,
+                    IsName = isName,
+                    IsWriteOnly = isWriteOnly
+                });
+            }
+
             private void LoadPawnNameToSav(PawnData pawn, XElement xElement)
             {
                 string name = pawn.GetParameter(Key).Value as string;
@@ -380,6 +415,21 @@ public override void LoadSavToPawn(PawnData pawn, XElement xElement, SavSlot sav
                     ++i;
                 }
             }
+
+            public override void CompilePaths(SavPathTable table, string path, SavSlot savSlot, bool isWriteOnly)
+            {
+                for (int i = 0; i < Keys.Count; ++i)
+                {
+                    if (Keys[i].Length > 0)
+                    {
+                        table.Add(ChildPath(path, SavPathTable.IndexSegment(i)), new SavPathEntry
+                        {
+                            Key = Keys[i],
+                            IsWriteOnly = isWriteOnly
+                        });
+                    }
+                }
+            }
         }
 
         private class SavConfigClassArray : SavConfigElement
@@ -418,25 +468,256 @@ public override void LoadSavToPawn(PawnData pawn, XElement xElement, SavSlot sav
                     ++i;
                 }
             }
+
+            public override void CompilePaths(SavPathTable table, string path, SavSlot savSlot, bool isWriteOnly)
+            {
+                for (int i = 0; i < Classes.Count; ++i)
+                {
+                    Classes[i].CompilePaths(table, ChildPath(path, SavPathTable.IndexSegment(i)), savSlot, isWriteOnly);
+                }
+            }
         }
 
         #endregion
 
+        /// <summary>
+        /// Formats a parameter the way the .sav file writes its value attribute
+        /// </summary>
+        private static string FormatSavValue(PawnParameter parameter)
+        {
+            string parameterString = (parameter.Value.ToInt64()).ToString();
+            if (parameter.FormatAsFloat)
+            {
+                parameterString += ".000000";
+            }
+            return parameterString;
+        }
+
         private static SavConfigClass savConfigRootClass = null;
+        private static Dictionary<SavSlot, SavPathTable> savPathTables = null;
+        private static SavPawnConfig savPawnConfig = null;
+        private static SavContext savContext = null;
 
         /// <summary>
-        /// Load a Pawn from the .sav file
+        /// Load a Pawn from the .sav file in a single pass,
+        /// matching each element against the compiled path table for the Pawn
         /// </summary>
         /// <param name="savSlot">The Pawn to load</param>
-        /// <param name="savRoot">The .sav file</param>
-        /// <returns>The loaded Pawn, or null if no Pawn was loaded</returns>
-        public static PawnData LoadPawnSav(SavSlot savSlot, XElement savRoot)
+        /// <param name="savReader">A reader positioned before the .sav file's root element</param>
+        /// <returns>The loaded Pawn</returns>
+        public static PawnData LoadPawnSav(SavSlot savSlot, XmlReader savReader)
         {
             PawnData loadPawn = new PawnData();
-            savConfigRootClass.LoadSavToPawn(loadPawn, savRoot, savSlot);
+            SavPathTable table = savPathTables[savSlot];
+            int entriesLeft = table.Entries.Count;
+
+            // the node and number of children seen so far of each open element, by depth
+            List<SavPathTable.Node> nodes = new List<SavPathTable.Node>();
+            List<int> childCounts = new List<int>();
+
+            savReader.Read();
+            while (entriesLeft > 0 && !savReader.EOF)
+            {
+                if (savReader.NodeType != XmlNodeType.Element)
+                {
+                    savReader.Read();
+                    continue;
+                }
+
+                int depth = savReader.Depth;
+                SavPathTable.Node node;
+                if (depth == 0)
+                {
+                    node = table.Root;
+                }
+                else
+                {
+                    SavPathTable.Node parent = nodes[depth - 1];
+                    int index = childCounts[depth - 1]++;
+                    node = parent.GetChild(
+                        parent.HasNamedChildren ? savReader.GetAttribute(ElementNameSavElementName) : null,
+                        index);
+                }
+
+                if (node == null)
+                {
+                    // not on the way to any parameter, so none of its children are either
+                    savReader.Skip();
+                    continue;
+                }
+
+                if (node.Entry != null)
+                {
+                    LoadSavEntryToPawn(loadPawn, node.Entry, savReader);
+                    --entriesLeft;
+                    savReader.Skip();
+                    continue;
+                }
+
+                if (nodes.Count == depth)
+                {
+                    nodes.Add(node);
+                    childCounts.Add(0);
+                }
+                else
+                {
+                    nodes[depth] = node;
+                    childCounts[depth] = 0;
+                }
+                savReader.Read();
+            }
+
             return loadPawn;
         }
 
+        /// <summary>
+        /// Load a Pawn from a packed .sav file, with DDsavelib extracting only the Pawn's values
+        /// </summary>
+        /// <param name="savSlot">The Pawn to load</param>
+        /// <param name="savPath">The path to the packed .sav file</param>
+        /// <returns>The loaded Pawn</returns>
+        public static PawnData ExtractPawnSav(SavSlot savSlot, string savPath)
+        {
+            if (savPawnConfig == null)
+            {
+                savPawnConfig = SavTool.CompileSavPawnConfig(savPathTables);
+            }
+            if (savContext == null)
+            {
+                savContext = SavTool.OpenSavContext();
+            }
+
+            SavPathTable table = savPathTables[savSlot];
+            SavPawnValue[] values = SavTool.ExtractPawnSav(savPath, savContext, savPawnConfig, savSlot, table.ValuePaths.Length);
+
+            // the values are in entry order, with a name's letters one after another
+            PawnData loadPawn = new PawnData();
+            int valueIndex = 0;
+            for (int i = 0; i < table.Entries.Count; ++i)
+            {
+                SavPathEntry entry = table.Entries[i].Value;
+                if (entry.IsWriteOnly)
+                {
+                    continue;
+                }
+
+                if (entry.IsName)
+                {
+                    StringBuilder sb = new StringBuilder();
+                    for (; valueIndex < values.Length && values[valueIndex].Entry == i; ++valueIndex)
+                    {
+                        sb.Append((char)values[valueIndex].Value);
+                    }
+                    loadPawn.GetOrAddParameter(entry.Key).Value = sb.ToString();
+                }
+                else if (valueIndex < values.Length && values[valueIndex].Entry == i)
+                {
+                    loadPawn.GetOrAddParameter(entry.Key).Value = values[valueIndex].Value;
+                    ++valueIndex;
+                }
+            }
+            return loadPawn;
+        }
+
+        private static void LoadSavEntryToPawn(PawnData pawn, SavPathEntry entry, XmlReader savReader)
+        {
+            if (entry.IsWriteOnly)
+            {
+                return;
+            }
+
+            if (!entry.IsName)
+            {
+                pawn.GetOrAddParameter(entry.Key).Value = Extensions.ParseSavValue(
+                    savReader.GetAttribute("value"),
+                    string.Format("with name={0}", savReader.GetAttribute(ElementNameSavElementName)));
+                return;
+            }
+
+            StringBuilder sb = new StringBuilder();
+            try
+            {
+                if (!savReader.IsEmptyElement)
+                {
+                    using (XmlReader letterReader = savReader.ReadSubtree())
+                    {
+                        while (letterReader.Read())
+                        {
+                            if (letterReader.NodeType != XmlNodeType.Element || letterReader.Depth != 1)
+                            {
+                                continue;
+                            }
+                            long value = Extensions.ParseSavValue(letterReader.GetAttribute("value"), letterReader.Name);
+                            if (value == 0)
+                            {
+                                break;
+                            }
+                            sb.Append((char)value);
+                        }
+                    }
+                }
+                pawn.GetOrAddParameter(entry.Key).Value = sb.ToString();
+            }
+            catch (Exception ex)
+            {
+                throw new XmlException(".sav file contained an invalid Pawn name.", ex);
+            }
+        }
+
+        /// <summary>
+        /// Get the value attributes that saving a Pawn to a .sav file rewrites,
+        /// the same ones SavePawnSav sets, so they can be patched into the unpacked text
+        /// </summary>
+        /// <param name="pawn">The Pawn to save</param>
+        /// <param name="savSlot">The Pawn to save to</param>
+        /// <param name="savPawn">The Pawn the .sav file has in that slot now, for how much of its name to clear</param>
+        /// <returns>The path of each element, in the syntax DDsavelib uses, and its new value attribute</returns>
+        public static List<KeyValuePair<string, string>> GetSavEdits(PawnData pawn, SavSlot savSlot, PawnData savPawn)
+        {
+            SavPathTable table = savPathTables[savSlot];
+            string[] valuePaths = table.ValuePaths;
+            List<KeyValuePair<string, string>> edits = new List<KeyValuePair<string, string>>();
+            int pathIndex = 0;
+            foreach (KeyValuePair<string, SavPathEntry> kvp in table.Entries)
+            {
+                SavPathEntry entry = kvp.Value;
+                PawnParameter parameter = pawn.GetParameter(entry.Key);
+                if (entry.IsName)
+                {
+                    // letters past the end of the name are zeroed up to the first 0 already there,
+                    // the way LoadPawnNameToSav stops
+                    string name = parameter == null ? null : parameter.Value as string;
+                    PawnParameter savName = savPawn.GetParameter(entry.Key);
+                    int savNameLength = savName == null || !(savName.Value is string) ? 0 : ((string)savName.Value).Length;
+                    int letterCount = name == null ? 0 : Math.Min(Math.Max(name.Length, savNameLength), SavPathTable.NameLength);
+                    for (int i = 0; i < letterCount; ++i)
+                    {
+                        string letter = i < name.Length ? ((int)name[i]).ToString() : "0";
+                        edits.Add(new KeyValuePair<string, string>(valuePaths[pathIndex + i], letter));
+                    }
+                    pathIndex += SavPathTable.NameLength;
+                    continue;
+                }
+
+                if (parameter != null)
+                {
+                    try
+                    {
+                        edits.Add(new KeyValuePair<string, string>(valuePaths[pathIndex], FormatSavValue(parameter)));
+                    }
+                    catch (Exception ex)
+                    {
+                        throw new XmlException(string.Format(
+                            "Error exporting parameter to .sav file element: {0}.",
+                            kvp.Key),
+                            ex);
+                    }
+                }
+                ++pathIndex;
+            }
+            return edits;
+        }
+
         /// <summary>
         /// Save a Pawn to the .sav file
         /// </summary>
@@ -717,6 +998,21 @@ private static void ParseSavConfig(XElement config)
             }
 
             savConfigRootClass = ParseSavClassElement(savTreeXml);
+
+            // compiled into DDsavelib again the next time it is needed
+            if (savPawnConfig != null)
+            {
+                savPawnConfig.Dispose();
+                savPawnConfig = null;
+            }
+
+            savPathTables = new Dictionary<SavSlot, SavPathTable>();
+            foreach (SavSlot savSlot in Enum.GetValues(typeof(SavSlot)))
+            {
+                SavPathTable table = new SavPathTable();
+                savConfigRootClass.CompilePaths(table, "", savSlot, false);
+                savPathTables.Add(savSlot, table);
+            }
         }
 
         private static SavConfigClass ParseSavClassElement(XElement xElement)
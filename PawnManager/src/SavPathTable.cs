@@ -0,0 +1,212 @@
+﻿using System.Collections.Generic;
+using System.Xml;
+
+namespace PawnManager
+{
+    /// <summary>
+    /// What to do with the .sav element at a compiled path
+    /// </summary>
+    public class SavPathEntry
+    {
+        /// <summary>
+        /// The key of the Pawn parameter the element holds
+        /// </summary>
+        public string Key { get; set; }
+
+        /// <summary>
+        /// The element is an array of letters holding the Pawn's name
+        /// </summary>
+        public bool IsName { get; set; }
+
+        /// <summary>
+        /// The element is written on export, but not read on import
+        /// </summary>
+        public bool IsWriteOnly { get; set; }
+    }
+
+    /// <summary>
+    /// The sav section of the config, flattened for one SavSlot into a table of
+    /// .sav element path -> Pawn parameter, so a .sav file can be matched in a single pass.
+    /// A path is a list of segments below the root element, separated by '/'.
+    /// Each segment is an element's 'name' attribute, or '#' and the element's index
+    /// among its siblings for elements in arrays.
+    /// </summary>
+    public class SavPathTable
+    {
+        public const char Separator = '/';
+        public const char IndexPrefix = '#';
+
+        /// <summary>
+        /// Name arrays in the .sav always hold this many letters, padded with zeros
+        /// </summary>
+        public const int NameLength = 25;
+
+        /// <summary>
+        /// One .sav element on the way to one or more parameters
+        /// </summary>
+        public class Node
+        {
+            private Dictionary<string, Node> named;
+            private List<Node> indexed;
+
+            /// <summary>
+            /// The parameter at this element, or null if it is only on the way to others
+            /// </summary>
+            public SavPathEntry Entry { get; set; }
+
+            /// <summary>
+            /// True if children are matched by their 'name' attribute,
+            /// so the caller only needs to read it when this is set
+            /// </summary>
+            public bool HasNamedChildren
+            {
+                get { return named != null; }
+            }
+
+            /// <summary>
+            /// Finds the child element with the given 'name' attribute,
+            /// or failing that the child at the given index.
+            /// </summary>
+            /// <param name="name">The child's 'name' attribute, or null if it has none</param>
+            /// <param name="index">The child's index among its siblings</param>
+            /// <returns>The matching child, or null if the child isn't on any path</returns>
+            public Node GetChild(string name, int index)
+            {
+                Node child;
+                if (name != null && named != null && named.TryGetValue(name, out child))
+                {
+                    return child;
+                }
+                if (indexed != null && index < indexed.Count)
+                {
+                    return indexed[index];
+                }
+                return null;
+            }
+
+            internal Node GetOrAddChild(string segment)
+            {
+                Node child;
+                if (segment.Length > 1 && segment[0] == IndexPrefix)
+                {
+                    int index = int.Parse(segment.Substring(1));
+                    if (indexed == null)
+                    {
+                        indexed = new List<Node>();
+                    }
+                    while (indexed.Count <= index)
+                    {
+                        indexed.Add(null);
+                    }
+                    child = indexed[index];
+                    if (child == null)
+                    {
+                        child = new Node();
+                        indexed[index] = child;
+                    }
+                }
+                else
+                {
+                    if (named == null)
+                    {
+                        named = new Dictionary<string, Node>();
+                    }
+                    if (!named.TryGetValue(segment, out child))
+                    {
+                        child = new Node();
+                        named.Add(segment, child);
+                    }
+                }
+                return child;
+            }
+        }
+
+        private List<KeyValuePair<string, SavPathEntry>> entries = new List<KeyValuePair<string, SavPathEntry>>();
+        private string[] valuePaths = null;
+
+        /// <summary>
+        /// The node for the .sav root element
+        /// </summary>
+        public Node Root { get; } = new Node();
+
+        /// <summary>
+        /// Every compiled path and its parameter, in config order
+        /// </summary>
+        public IReadOnlyList<KeyValuePair<string, SavPathEntry>> Entries
+        {
+            get { return entries; }
+        }
+
+        /// <summary>
+        /// The path of every element holding a value, in the order of Entries,
+        /// with each name expanded into the paths of its NameLength letters.
+        /// Names are escaped the way they are written in the .sav text,
+        /// so these can be handed to DDsavelib as they are.
+        /// </summary>
+        public string[] ValuePaths
+        {
+            get
+            {
+                if (valuePaths == null)
+                {
+                    List<string> paths = new List<string>();
+                    foreach (KeyValuePair<string, SavPathEntry> entry in entries)
+                    {
+                        string path = EscapePath(entry.Key);
+                        if (entry.Value.IsName)
+                        {
+                            for (int i = 0; i < NameLength; ++i)
+                            {
+                                paths.Add(path + Separator + IndexSegment(i));
+                            }
+                        }
+                        else
+                        {
+                            paths.Add(path);
+                        }
+                    }
+                    valuePaths = paths.ToArray();
+                }
+                return valuePaths;
+            }
+        }
+
+        /// <summary>
+        /// Escapes a path the way its names are written in the .sav text
+        /// </summary>
+        public static string EscapePath(string path)
+        {
+            return path.Replace("&", "&amp;").Replace("<", "&lt;").Replace("\"", "&quot;");
+        }
+
+        /// <summary>
+        /// Returns the path segment for the element at the given index in an array
+        /// </summary>
+        public static string IndexSegment(int index)
+        {
+            return IndexPrefix + index.ToString();
+        }
+
+        /// <summary>
+        /// Adds a parameter at the given path.
+        /// Throws an exception if the path already has one.
+        /// </summary>
+        public void Add(string path, SavPathEntry entry)
+        {
+            Node node = Root;
+            foreach (string segment in path.Split(Separator))
+            {
+                node = node.GetOrAddChild(segment);
+            }
+            if (node.Entry != null)
+            {
+                throw new XmlException(string.Format(
+                    "Save config maps more than one parameter to {0}",
+                    path));
+            }
+            node.Entry = entry;
+            entries.Add(new KeyValuePair<string, SavPathEntry>(path, entry));
+            valuePaths = null;
+        }
+    }
+}
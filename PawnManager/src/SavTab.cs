@@ -57,15 +57,27 @@ private set
         /// <returns>The loaded Pawn</returns>
         public PawnData Import()
         {
-            bool? isPacked;
-            XElement savRoot = LoadSav(out isPacked);
+            if (!File.Exists(SavPath))
+            {
+                throw new Exception(string.Format("File {0} does not exist", SavPath));
+            }
 
-            return PawnIO.LoadPawnSav(SavSourcePawn, savRoot);
+            // DDsavelib extracts the Pawn's values from packed saves, and remembers where they were for next time
+            if (SavTool.ValidateSav(SavPath))
+            {
+                return PawnIO.ExtractPawnSav(SavSourcePawn, SavPath);
+            }
+
+            // the Pawn is matched in a single pass, so the .sav doesn't need to be loaded as a tree
+            using (XmlReader savReader = XmlReader.Create(SavPath))
+            {
+                return PawnIO.LoadPawnSav(SavSourcePawn, savReader);
+            }
         }
 
-        private string EncodeXml(XElement xml)
+        private byte[] EncodeXml(XElement xml)
         {
-            string ret = "";
+            byte[] ret = null;
             using (MemoryStream memoryStream = new MemoryStream())
             {
                 UTF8Encoding encoding = new UTF8Encoding(false);
@@ -81,63 +93,62 @@ private string EncodeXml(XElement xml)
                         xmlWriter.WriteWhitespace("\n");
                     }
 
-                    byte[] buffer = new byte[memoryStream.Length];
-                    memoryStream.Seek(0, SeekOrigin.Begin);
-                    memoryStream.Read(buffer, 0, (int)memoryStream.Length);
+                    // " />" becomes "/>" while copying the bytes out, which is safe in UTF-8 since they are all ASCII
+                    byte[] buffer = memoryStream.GetBuffer();
+                    int length = (int)memoryStream.Length;
+                    int spaceCount = 0;
+                    for (int i = 0; i < length; ++i)
+                    {
+                        if (IsSpaceBeforeClose(buffer, length, i))
+                        {
+                            ++spaceCount;
+                        }
+                    }
 
-                    string replaceStr = encoding.GetString(buffer, 0, (int)memoryStream.Length);
-                    ret = replaceStr.Replace(" />", "/>");
+                    ret = new byte[length - spaceCount];
+                    int used = 0;
+                    for (int i = 0; i < length; ++i)
+                    {
+                        if (!IsSpaceBeforeClose(buffer, length, i))
+                        {
+                            ret[used++] = buffer[i];
+                        }
+                    }
                 }
             }
             return ret;
         }
 
+        private static bool IsSpaceBeforeClose(byte[] buffer, int length, int i)
+        {
+            return i + 2 < length && buffer[i] == ' ' && buffer[i + 1] == '/' && buffer[i + 2] == '>';
+        }
+
         /// <summary>
-        /// Loads the .sav file specified by SavPath, using DDsavelib if it is packed,
-        /// replaces the Pawn in the slot specified by SavSourcePawn with the given Pawn,
-        /// then writes the modified .sav back, repacking it using DDsavelib if it was originally packed.
+        /// Replaces the Pawn in the slot specified by SavSourcePawn of the .sav file specified by SavPath
+        /// with the given Pawn.
+        /// A packed .sav has only the Pawn's values rewritten in its unpacked text by DDsavelib, then is repacked;
+        /// an unpacked one is loaded, modified and written back.
         /// Throws an exception if anything fails.
         /// </summary>
         /// <param name="exportPawn">The Pawn to export to the .sav file</param>
         public void Export(PawnData exportPawn)
-        {
-            bool? isPacked;
-            XElement savRoot = LoadSav(out isPacked);
-
-            PawnIO.SavePawnSav(exportPawn, SavSourcePawn, savRoot);
-
-            string encoded = EncodeXml(savRoot);
-
-            if (isPacked == true)
-            {
-                SavTool.RepackSav(SavPath, encoded);
-            }
-            else if (isPacked == false)
-            {
-                File.WriteAllText(SavPath, encoded, new UTF8Encoding(false));
-            }
-        }
-        
-        private XElement LoadSav(out bool? isPacked)
         {
             if (!File.Exists(SavPath))
             {
                 throw new Exception(string.Format("File {0} does not exist", SavPath));
             }
 
-            isPacked = null;
-
             if (SavTool.ValidateSav(SavPath))
             {
-                isPacked = true;
-                string unpackedText = SavTool.UnpackSav(SavPath);
-                return XElement.Parse(unpackedText, LoadOptions.PreserveWhitespace);
-            }
-            else
-            {
-                isPacked = false;
-                return XElement.Load(SavPath, LoadOptions.PreserveWhitespace);
+                PawnData savPawn = PawnIO.ExtractPawnSav(SavSourcePawn, SavPath);
+                SavTool.PatchSav(SavPath, PawnIO.GetSavEdits(exportPawn, SavSourcePawn, savPawn), SavRepackProfile.Fastest);
+                return;
             }
+
+            XElement savRoot = XElement.Load(SavPath, LoadOptions.PreserveWhitespace);
+            PawnIO.SavePawnSav(exportPawn, SavSourcePawn, savRoot);
+            File.WriteAllBytes(SavPath, EncodeXml(savRoot));
         }
         
         private const string DDDAID = "367500";
@@ -1,21 +1,184 @@
 ﻿using System;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using System.Text;
 
 namespace PawnManager
 {
+    /// <summary>
+    /// How hard DDsavelib compresses a repacked .sav, from quickest to smallest
+    /// </summary>
+    public enum SavRepackProfile
+    {
+        Fastest = 0,
+        Balanced = 1,
+        Smallest = 2
+    }
+
+    /// <summary>
+    /// One value DDsavelib extracted for a Pawn
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SavPawnValue
+    {
+        /// <summary>
+        /// The index of the entry in the Pawn's SavPathTable
+        /// </summary>
+        public uint Entry;
+
+        /// <summary>
+        /// The element's value, or for a name, the next letter of it
+        /// </summary>
+        public long Value;
+    }
+
+    /// <summary>
+    /// The sav section of the config, compiled into DDsavelib for every SavSlot
+    /// </summary>
+    public sealed class SavPawnConfig : SafeHandle
+    {
+        internal SavPawnConfig(IntPtr config)
+            : base(IntPtr.Zero, true)
+        {
+            SetHandle(config);
+        }
+
+        public override bool IsInvalid
+        {
+            get { return handle == IntPtr.Zero; }
+        }
+
+        protected override bool ReleaseHandle()
+        {
+            SavTool.CloseSavPawnConfig(handle);
+            return true;
+        }
+    }
+
+    /// <summary>
+    /// DDsavelib's streams and caches for the .sav files of a session, kept from one call to the next
+    /// </summary>
+    public sealed class SavContext : SafeHandle
+    {
+        internal SavContext(IntPtr context)
+            : base(IntPtr.Zero, true)
+        {
+            SetHandle(context);
+        }
+
+        public override bool IsInvalid
+        {
+            get { return handle == IntPtr.Zero; }
+        }
+
+        protected override bool ReleaseHandle()
+        {
+            SavTool.CloseSavContext(handle);
+            return true;
+        }
+    }
+
     public static class SavTool
     {
-        const int AllocSize = 25 * 1024 * 1024;
         const string DLLName = "DDsavelib.dll";
 
         [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern int Unpack([MarshalAs(UnmanagedType.LPStr)]string savPath, IntPtr unpackedSavPtr);
+        private static extern int UnpackDocument([MarshalAs(UnmanagedType.LPStr)]string savPath, out IntPtr document);
 
         [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
-        private static extern int Repack([MarshalAs(UnmanagedType.LPStr)]string outputPath,
-                                            [MarshalAs(UnmanagedType.LPStr)]string xmlData,
-                                            uint dataSize);
+        private static extern int SavDocumentGetText(IntPtr document, out IntPtr text, out uint size);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern int SavDocumentRepackEdit(IntPtr document,
+                                            [MarshalAs(UnmanagedType.LPStr)]string outputPath,
+                                            byte[] data,
+                                            UIntPtr size,
+                                            int profile,
+                                            uint budget);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void SavDocumentClose(IntPtr document);
+
+        // the text of a SavDocument, read in place and closed along with the buffer
+        private sealed class SavDocumentBuffer : SafeBuffer
+        {
+            private IntPtr document;
+
+            public SavDocumentBuffer(IntPtr document)
+                : base(true)
+            {
+                this.document = document;
+                IntPtr text;
+                uint size;
+                SavDocumentGetText(document, out text, out size);
+                SetHandle(text);
+                Initialize(size);
+            }
+
+            public IntPtr Document
+            {
+                get { return document; }
+            }
+
+            protected override bool ReleaseHandle()
+            {
+                SavDocumentClose(document);
+                return true;
+            }
+        }
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern int SavPawnConfigOpen(out IntPtr config);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern int SavPawnConfigAdd(SavPawnConfig config, uint slot, [MarshalAs(UnmanagedType.LPStr)]string path, int flags);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void SavPawnConfigClose(IntPtr config);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern int SavContextOpen(uint threadCount, out IntPtr context);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern void SavContextClose(IntPtr context);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern int SavContextExtractPawn(SavContext context,
+                                            [MarshalAs(UnmanagedType.LPStr)]string savPath,
+                                            SavPawnConfig config,
+                                            uint slot,
+                                            [Out]SavPawnValue[] values,
+                                            uint capacity,
+                                            out uint count);
+
+        // flags of a compiled SavPathEntry
+        private const int SavPawnName = 1;
+        private const int SavPawnWriteOnly = 2;
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct SavXmlEdit
+        {
+            [MarshalAs(UnmanagedType.LPStr)]
+            public string Path;
+            [MarshalAs(UnmanagedType.LPStr)]
+            public string Value;
+        }
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern int PatchXml(IntPtr text,
+                                            uint size,
+                                            SavXmlEdit[] edits,
+                                            uint editCount,
+                                            byte[] outText,
+                                            uint outCapacity,
+                                            out uint outSize);
+
+        [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
+        private static extern int RepackBytes([MarshalAs(UnmanagedType.LPStr)]string outputPath,
+                                            byte[] data,
+                                            UIntPtr size,
+                                            int profile,
+                                            uint budget);
 
         [DllImport(DLLName, CallingConvention = CallingConvention.Cdecl)]
         private static extern int Validate([MarshalAs(UnmanagedType.LPStr)]string savPath);
@@ -26,6 +189,12 @@ public static class SavTool
             { 2, "Unable to write to file" },
             { 3, "Invalid format" },
             { 4, "Unpacking error" },
+            { 5, "Unpacked data is larger than the output buffer" },
+            { 6, "Unpacking was cancelled" },
+            { 7, "Checksum mismatch, the file is corrupted" },
+            { 8, "Save element not found" },
+            { 9, "The packed save is too large to fit in a save slot" },
+            { 10, "Invalid argument" },
             { -2, "EZ stream error" },
             { -3, "EZ data error" },
             { -4, "EZ memory error" },
@@ -47,11 +216,40 @@ private static string CodeToMessage(int err)
         /// <param name="savPath">The path to the file to write</param>
         /// <param name="savText">The unpacked XML</param>
         public static void RepackSav(string savPath, string savText)
+        {
+            RepackSav(savPath, savText, SavRepackProfile.Balanced);
+        }
+
+        /// <summary>
+        /// Writes a packed .sav file, given the unpacked XML text, compressing it with the given profile.
+        /// If the result doesn't fit in the .sav, stronger profiles are tried before giving up,
+        /// and the file is only written once one fits.
+        /// May throw an exception from accessing the DLL, or if repacking failed.
+        /// </summary>
+        /// <param name="savPath">The path to the file to write</param>
+        /// <param name="savText">The unpacked XML</param>
+        /// <param name="profile">How hard to compress</param>
+        public static void RepackSav(string savPath, string savText, SavRepackProfile profile)
+        {
+            RepackSav(savPath, Encoding.UTF8.GetBytes(savText), profile);
+        }
+
+        /// <summary>
+        /// Writes a packed .sav file, given the unpacked XML as UTF-8 bytes, compressing it with the given profile.
+        /// The bytes are handed to DDsavelib as they are, without being copied.
+        /// If the result doesn't fit in the .sav, stronger profiles are tried before giving up,
+        /// and the file is only written once one fits.
+        /// May throw an exception from accessing the DLL, or if repacking failed.
+        /// </summary>
+        /// <param name="savPath">The path to the file to write</param>
+        /// <param name="savData">The unpacked XML, encoded as UTF-8</param>
+        /// <param name="profile">How hard to compress</param>
+        public static void RepackSav(string savPath, byte[] savData, SavRepackProfile profile)
         {
             int code = 0;
             try
             {
-                code = Repack(savPath, savText, (uint)savText.Length);
+                code = RepackBytes(savPath, savData, (UIntPtr)savData.Length, (int)profile, 0);
             }
             catch (Exception ex)
             {
@@ -64,42 +262,188 @@ public static void RepackSav(string savPath, string savText)
         }
 
         /// <summary>
-        /// Gets the unpacked XML from a packed .sav file.
-        /// May throw an exception from accessing the DLL, or if unpacking failed.
+        /// Rewrites value attributes of a packed .sav file, then repacks it with the given profile.
+        /// DDsavelib patches only the edited values into the unpacked text, which is never parsed into a tree,
+        /// and repacking keeps the compressed data from before the first edit, which the unpacked document still has.
+        /// If the result doesn't fit in the .sav, stronger profiles are tried before giving up.
+        /// May throw an exception from accessing the DLL, or if unpacking, patching or repacking failed.
         /// </summary>
         /// <param name="savPath">The path to the .sav file</param>
-        /// <returns>The unpacked XML of the .sav file</returns>
-        public static string UnpackSav(string savPath)
+        /// <param name="edits">The path of each element, in DDsavelib's syntax, and its new value attribute, already escaped</param>
+        /// <param name="profile">How hard to compress</param>
+        public static void PatchSav(string savPath, IList<KeyValuePair<string, string>> edits, SavRepackProfile profile)
         {
             int code = 0;
-            string unpackedText = "";
+            SavDocumentBuffer buffer = null;
 
+            try
             {
-                IntPtr output = Marshal.AllocHGlobal(AllocSize);
-                try
+                IntPtr document;
+                code = UnpackDocument(savPath, out document);
+                if (code == 0)
                 {
-                    code = Unpack(savPath, output);
+                    buffer = new SavDocumentBuffer(document);
+
+                    // the unpacked text plus every new value is always enough room
+                    SavXmlEdit[] xmlEdits = new SavXmlEdit[edits.Count];
+                    long capacity = (long)buffer.ByteLength;
+                    for (int i = 0; i < edits.Count; ++i)
+                    {
+                        xmlEdits[i].Path = edits[i].Key;
+                        xmlEdits[i].Value = edits[i].Value;
+                        capacity += Encoding.UTF8.GetByteCount(edits[i].Value);
+                    }
+
+                    byte[] patched = new byte[capacity];
+                    uint patchedSize = 0;
+                    code = PatchXml(buffer.DangerousGetHandle(),
+                                    (uint)buffer.ByteLength,
+                                    xmlEdits,
+                                    (uint)xmlEdits.Length,
+                                    patched,
+                                    (uint)capacity,
+                                    out patchedSize);
                     if (code == 0)
                     {
-                        unpackedText = Marshal.PtrToStringAnsi(output);
+                        code = SavDocumentRepackEdit(buffer.Document, savPath, patched, (UIntPtr)patchedSize, (int)profile, 0);
+                    }
+                }
+            }
+            catch (Exception ex)
+            {
+                ThrowDDsavelibException(ex);
+            }
+            finally
+            {
+                if (buffer != null)
+                {
+                    buffer.Dispose();
+                }
+            }
+
+            if (code != 0)
+            {
+                throw new Exception(CodeToMessage(code));
+            }
+        }
+
+        /// <summary>
+        /// Compiles the sav section of the config into DDsavelib, for ExtractPawnSav.
+        /// May throw an exception from accessing the DLL, or if DDsavelib couldn't compile an entry.
+        /// </summary>
+        /// <param name="tables">The config compiled for each SavSlot</param>
+        /// <returns>The compiled config, which DDsavelib keeps until it is disposed</returns>
+        public static SavPawnConfig CompileSavPawnConfig(IDictionary<SavSlot, SavPathTable> tables)
+        {
+            SavPawnConfig config = null;
+            try
+            {
+                IntPtr handle;
+                int code = SavPawnConfigOpen(out handle);
+                if (code != 0)
+                {
+                    throw new Exception(CodeToMessage(code));
+                }
+                config = new SavPawnConfig(handle);
+                foreach (KeyValuePair<SavSlot, SavPathTable> table in tables)
+                {
+                    foreach (KeyValuePair<string, SavPathEntry> entry in table.Value.Entries)
+                    {
+                        int flags = (entry.Value.IsName ? SavPawnName : 0) | (entry.Value.IsWriteOnly ? SavPawnWriteOnly : 0);
+                        code = SavPawnConfigAdd(config, (uint)table.Key, SavPathTable.EscapePath(entry.Key), flags);
+                        if (code != 0)
+                        {
+                            throw new Exception(CodeToMessage(code));
+                        }
                     }
                 }
-                catch (Exception ex)
+            }
+            catch (Exception ex)
+            {
+                if (config != null)
                 {
-                    ThrowDDsavelibException(ex);
+                    config.Dispose();
                 }
-                finally
+                ThrowDDsavelibException(ex);
+            }
+            return config;
+        }
+
+        /// <summary>
+        /// Opens a context for ExtractPawnSav, with one thread, since it only unpacks.
+        /// May throw an exception from accessing the DLL, or if DDsavelib couldn't make the context.
+        /// </summary>
+        /// <returns>The context, which DDsavelib keeps until it is disposed</returns>
+        public static SavContext OpenSavContext()
+        {
+            SavContext context = null;
+            int code = 0;
+            try
+            {
+                IntPtr handle;
+                code = SavContextOpen(1, out handle);
+                if (code == 0)
                 {
-                    Marshal.FreeHGlobal(output);
+                    context = new SavContext(handle);
                 }
             }
+            catch (Exception ex)
+            {
+                ThrowDDsavelibException(ex);
+            }
+
+            if (code != 0)
+            {
+                throw new Exception(CodeToMessage(code));
+            }
+            return context;
+        }
+
+        /// <summary>
+        /// Reads the values of the Pawn in the given slot of a packed .sav file, in one call to DDsavelib.
+        /// Only the values cross over from DDsavelib, with write-only entries left out,
+        /// and each name given as its letters up to the first 0.
+        /// DDsavelib caches where the elements are next to the .sav file,
+        /// and once the context has unpacked the file, only the text around them is unpacked.
+        /// May throw an exception from accessing the DLL, or if unpacking failed.
+        /// </summary>
+        /// <param name="savPath">The path to the .sav file</param>
+        /// <param name="context">The context to unpack on, one call at a time</param>
+        /// <param name="config">The compiled config</param>
+        /// <param name="savSlot">The Pawn to read</param>
+        /// <param name="capacity">The most values the Pawn can have, the length of its table's ValuePaths</param>
+        /// <returns>The values, in the order of the table's entries</returns>
+        public static SavPawnValue[] ExtractPawnSav(string savPath, SavContext context, SavPawnConfig config, SavSlot savSlot, int capacity)
+        {
+            int code = 0;
+            SavPawnValue[] values = new SavPawnValue[capacity];
+            uint count = 0;
+            try
+            {
+                code = SavContextExtractPawn(context, savPath, config, (uint)savSlot, values, (uint)capacity, out count);
+            }
+            catch (Exception ex)
+            {
+                ThrowDDsavelibException(ex);
+            }
 
             if (code != 0)
             {
                 throw new Exception(CodeToMessage(code));
             }
-            
-            return unpackedText;
+
+            Array.Resize(ref values, (int)count);
+            return values;
+        }
+
+        internal static void CloseSavPawnConfig(IntPtr config)
+        {
+            SavPawnConfigClose(config);
+        }
+
+        internal static void CloseSavContext(IntPtr context)
+        {
+            SavContextClose(context);
         }
 
         /// <summary>